@@ -121,6 +121,20 @@ void anglerange::setcircle(bool value)
     fullcircle=value;
 }
 
+double anglerange::getsize() const
+{
+    if(isempty())
+    {
+        return(0.0);
+    }
+    if(fullcircle)
+    {
+        return(2.0*M_PI);
+    }
+    //angleclass keeps the difference in [0:2pi[, which also takes care of ranges around zero.
+    return((upperborder-lowerborder).getval());
+}
+
 bool anglerange::isinside(const angleclass &val) const
 {
     if(isempty())
@@ -250,7 +264,7 @@ anglerange anglerange::combine(const anglerange &other) const
         {
             retval = *this;
         }
-        if(other.fullcircle)
+        else if(other.fullcircle)
         {
             retval = other;
             retval.setsorttype(sortby);
@@ -70,6 +70,7 @@ public:
     angleclass getlower() const; //warning: Does not check if empty, does not check if circle
     angleclass getupper() const; //warning: Does not check if empty, does not check if circle
     bool isinside(const angleclass &val) const; //check if angleclas val is in the range.
+    double getsize() const; //upper-lower, counter-clockwise, in radians. 2pi for a full circle, 0 if empty.
 
     //to deal with full circles:
     void setcircle(bool value);
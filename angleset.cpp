@@ -32,6 +32,7 @@
  */
 
 #include "angleset.h"
+#include <stdint.h>
 
 angleset::angleset()
 {
@@ -121,6 +122,13 @@ void angleset::add(const anglerange &value)
     }
 }
 
+void angleset::append(const anglerange &value)
+{
+    assert(storage.empty() || storage.back().getupper()<value.getlower());
+    storage.push_back(value);
+    storage.back().setsorttype(anglerange::SRT_LOWER);
+}
+
 void angleset::add(const angleset &value)
 {
     storage.reserve(storage.size()+value.storage.size());
@@ -140,38 +148,71 @@ void angleset::add(const double &lower, const double &upper)
 
 
 angleset angleset::overlap(const anglerange &other)
+{
+    angleset retval;
+    overlap(other,retval);
+    return(retval);
+}
+
+void angleset::overlap(const anglerange &other, angleset &target)
 {
     if(!consistent)
         combine();
+    for(std::vector<anglerange>::const_iterator i=storage.begin();i!=storage.end();++i)
+    {
+        target.add(i->overlap(other)); //given that add checks if the value passed to it is empty: this should work?!?
+    }
+}
+
+angleset angleset::overlap(const angleset &other)
+{
     angleset retval;
-    for_each(
-                storage.begin(),
-                storage.end(),
-                [&](anglerange i)
-                {
-                    retval.add(i.overlap(other)); //given that add checks if the value passed to it is empty: this should work?!?
-                }
-    );
+    overlap(other,retval);
     return(retval);
 }
 
-angleset angleset::overlap(const angleset &other)
+void angleset::overlap(const angleset &other, angleset &target)
 {
     //just add the overlap of each anglerange in other ;-)
-    angleset retval;
-    for_each(
-                other.storage.begin(),
-                other.storage.end(),
-                [&](anglerange i)
-                {
-                    retval.add(overlap(i));
-                }
-                );
+    target.clear();
+    for(std::vector<anglerange>::const_iterator i=other.storage.begin();i!=other.storage.end();++i)
+    {
+        overlap(*i,target);
+    }
+    //as if a set had been added for each range of other, even an empty one.
+    if(!other.storage.empty())
+    {
+        target.consistent=false;
+    }
     if(!other.consistent)
-        retval.combine();
+        target.combine();
+}
+
+angleset angleset::clip(const anglerange &window) const
+{
+    angleset retval;
+    for(std::vector<anglerange>::const_iterator i=storage.begin();i!=storage.end();++i)
+    {
+        retval.add(i->overlap(window));
+    }
     return(retval);
 }
 
+bool angleset::intersects(const angleset &other) const
+{
+    for(std::vector<anglerange>::const_iterator i=storage.begin();i!=storage.end();++i)
+    {
+        for(std::vector<anglerange>::const_iterator j=other.storage.begin();j!=other.storage.end();++j)
+        {
+            if(!i->overlap(*j).isempty())
+            {
+                return(true);
+            }
+        }
+    }
+    return(false);
+}
+
 std::vector<anglerange> angleset::getranges()
 {
     if(!consistent)
@@ -186,6 +227,117 @@ const std::vector<anglerange>& angleset::getrangesref()
     return storage;
 }
 
+const std::vector<anglerange>& angleset::getrawref() const
+{
+    return storage;
+}
+
+void angleset::prune(double minwidth)
+{
+    if(!consistent)
+        combine();
+    storage.erase(
+                std::remove_if(
+                    storage.begin(),
+                    storage.end(),
+                    [&](const anglerange &i)
+                    {
+                        return(i.getsize()<minwidth);
+                    }
+                    ),
+                storage.end()
+                );
+}
+
+void angleset::prune(double minwidth, const anglerange &window)
+{
+    if(!consistent)
+        combine();
+    storage.erase(
+                std::remove_if(
+                    storage.begin(),
+                    storage.end(),
+                    [&](const anglerange &i)
+                    {
+                        return(i.getsize()<minwidth && !i.isinside(window.getlower()) && !i.isinside(window.getupper()));
+                    }
+                    ),
+                storage.end()
+                );
+}
+
+bool angleset::save(FILE *file)
+{
+    sort();
+    uint64_t count=storage.size();
+    uint32_t flags[2]={iscircle() ? 1u : 0u,0u};
+    if(flags[0])
+    {
+        count=0;
+    }
+    if(fwrite(&count,sizeof(count),1,file)!=1 || fwrite(flags,sizeof(flags),1,file)!=1)
+    {
+        return(false);
+    }
+    for(uint64_t i=0;i<count;i++)
+    {
+        double pair[2]={storage[i].getlower().getval(),storage[i].getupper().getval()};
+        if(fwrite(pair,sizeof(pair),1,file)!=1)
+        {
+            return(false);
+        }
+    }
+    return(true);
+}
+
+bool angleset::load(FILE *file)
+{
+    clear();
+    uint64_t count;
+    uint32_t flags[2];
+    if(fread(&count,sizeof(count),1,file)!=1 || fread(flags,sizeof(flags),1,file)!=1)
+    {
+        return(false);
+    }
+    if(flags[0]&1)
+    {
+        anglerange circle;
+        circle.setcircle(true);
+        storage.push_back(circle);
+        storage.back().setsorttype(anglerange::SRT_LOWER);
+        return(true);
+    }
+    //a corrupt count must not turn into a huge allocation: it has to fit into what is left of the file.
+    const long here=ftell(file);
+    if(here>=0 && fseek(file,0,SEEK_END)==0)
+    {
+        const long end=ftell(file);
+        if(end<here || fseek(file,here,SEEK_SET)!=0 || count>static_cast<uint64_t>(end-here)/(2*sizeof(double)))
+        {
+            return(false);
+        }
+    }
+    //where the file can't seek, the pairs are read in blocks, so at most one block is allocated in vain.
+    const uint64_t block=4096;
+    std::vector<double> pairs(2*std::min(count,block));
+    for(uint64_t done=0;done<count;)
+    {
+        const uint64_t now=std::min(count-done,block);
+        if(fread(&pairs[0],2*sizeof(double),now,file)!=now)
+        {
+            clear();
+            return(false);
+        }
+        for(uint64_t i=0;i<now;i++)
+        {
+            storage.push_back(anglerange(pairs[2*i],pairs[2*i+1]));
+            storage.back().setsorttype(anglerange::SRT_LOWER);
+        }
+        done+=now;
+    }
+    return(true);
+}
+
 void angleset::clear()
 {
     storage.clear();
@@ -36,6 +36,7 @@
 #include <vector>
 #include <cassert>
 #include <algorithm>
+#include <cstdio>
 #include "anglerange.h"
 
 class angleset
@@ -59,6 +60,11 @@ public:
     void add(const double &lower, const double &upper);
     //void remove(const double &lower, const double &upper); //not implemented yet
 
+    //adds a range that is known to come after everything in the set, sorted by lower border, without touching any
+    //of it. Nothing needs to be combined then, so a consolidated set stays consolidated. For results that are
+    //generated in order, where combining them one by one would cost quadratic time for nothing.
+    void append(const anglerange &value);
+
     //here it gets interesting: add or remove complete sets.
     void add(const angleset &value);
     //void remove(const angleset &value); //not implemented yet
@@ -70,9 +76,33 @@ public:
     //is consistent to older code in anglerange.h
     angleset overlap(const anglerange &other);
     angleset overlap(const angleset &other);
+    //the same, but the overlap with a range is added to target, and the one with a set replaces what target
+    //held. target keeps its storage, so doing this again and again with the same target doesn't allocate once
+    //it is large enough. target must be neither this set nor other.
+    void overlap(const anglerange &other, angleset &target);
+    void overlap(const angleset &other, angleset &target);
+    //like overlap, but doesn't consolidate this set first. Meant for cutting a small window out of a big set
+    //that hasn't been consolidated yet: the cost is linear in the size of this set, and only the (small)
+    //result gets consolidated, once it's used.
+    angleset clip(const anglerange &window) const;
+    //true if this set and other have at least one angle in common. Stops at the first one, nothing is
+    //consolidated or stored.
+    bool intersects(const angleset &other) const;
 
     void reserve(size_t n); //just forwards storage's reserve function.
 
+    //removes all ranges narrower than minwidth (radians), after consolidating.
+    void prune(double minwidth);
+    //the same, but ranges that touch a border of window are kept: they might go on outside of it.
+    void prune(double minwidth, const anglerange &window);
+
+    //binary storage, consolidated and sorted first: uint64 count, uint32 flags (1: full circle), uint32 zero,
+    //then count pairs of doubles (lower, upper), radians. Byte order of the machine. false if writing failed.
+    bool save(FILE *file);
+    //replaces the contents by what save() wrote. They are taken as they are, without consolidating them again.
+    //false if the file ends early.
+    bool load(FILE *file);
+
     //empties the range
     void clear();
 
@@ -85,6 +115,9 @@ public:
     //reference, to keep this relatively fast, const so you don't accidentally modify it.
     //If the internal storage format changes, this might be changed to give a copy instead.
     const std::vector<anglerange>& getrangesref(); //I hope this does what I think it does...
+    //the internal storage as it is, without consolidating it first. Filled by add() on an empty set, these are
+    //the ranges in the order they were added.
+    const std::vector<anglerange>& getrawref() const;
 
 };
 
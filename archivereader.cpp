@@ -0,0 +1,218 @@
+/*
+ * LatticeMatch calculator - reading compressed archives
+ * Copyright (C) 2015 Andreas Grois
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ *
+ * Random access to the records of an archive written by archivewriter. See archivewriter.h for the layout.
+ *
+ * This class is part of the LatticeMatch program.
+ *
+ * To contact the author either use electronic mail: Andreas Grois <andreas.grois@jku.at>
+ * or write to:
+ * Andreas Grois, Institute for Semiconductor and SolidState physics, Johannes Kepler University,
+ * Altenbergerstraße 69, 4040 Linz, AUSTRIA
+ */
+
+#include "archivereader.h"
+#include "archivewriter.h"
+#include <cstring>
+
+archivereader::archivereader()
+{
+    file=0;
+    keyinterval=1;
+    tableposition=0;
+    lastindex=-1;
+}
+
+archivereader::~archivereader()
+{
+    close();
+}
+
+void archivereader::close()
+{
+    if(file)
+    {
+        fclose(file);
+        file=0;
+    }
+    offsets.clear();
+    lastindex=-1;
+}
+
+bool archivereader::open(const char *name)
+{
+    close();
+    file=fopen(name,"rb");
+    if(!file)
+    {
+        return(false);
+    }
+    char magic[8];
+    uint32_t version;
+    if(fread(magic,1,8,file)!=8 || memcmp(magic,"LATARCH1",8)!=0 ||
+            fread(&version,sizeof(version),1,file)!=1 || version!=1 ||
+            fread(&keyinterval,sizeof(keyinterval),1,file)!=1 || keyinterval==0)
+    {
+        close();
+        return(false);
+    }
+    uint64_t trailer[2];
+    if(fseek(file,-24,SEEK_END)!=0 || fread(trailer,sizeof(uint64_t),2,file)!=2 || fread(magic,1,8,file)!=8 || memcmp(magic,"LATARCHE",8)!=0)
+    {
+        //no trailer: the writer didn't finish.
+        close();
+        return(false);
+    }
+    //the trailer is the last thing in the file, and has already been read, so this is where it ends.
+    const long filesize=ftell(file);
+    tableposition=trailer[0];
+    //a broken trailer must not turn into a huge allocation: the table has to fit between its start and the trailer.
+    if(filesize<40 || tableposition<16 || tableposition>static_cast<uint64_t>(filesize-24) ||
+            trailer[1]>(static_cast<uint64_t>(filesize-24)-tableposition)/sizeof(uint64_t))
+    {
+        close();
+        return(false);
+    }
+    offsets.resize(trailer[1]);
+    if(fseek(file,tableposition,SEEK_SET)!=0 || (trailer[1]>0 && fread(&offsets[0],sizeof(uint64_t),trailer[1],file)!=trailer[1]))
+    {
+        close();
+        return(false);
+    }
+    //records follow the header one after the other, and end where the table starts.
+    for(size_t k=0;k<offsets.size();k++)
+    {
+        if(offsets[k]<(k>0 ? offsets[k-1] : 16) || offsets[k]>tableposition)
+        {
+            close();
+            return(false);
+        }
+    }
+    return(true);
+}
+
+uint64_t archivereader::count() const
+{
+    return(offsets.size());
+}
+
+//decodes record k into last. last has to hold record k-1, unless k is a keyframe.
+bool archivereader::decode(uint64_t k)
+{
+    uint64_t end = k+1<offsets.size() ? offsets[k+1] : tableposition;
+    scratch.resize(end-offsets[k]);
+    if(fseek(file,offsets[k],SEEK_SET)!=0 || (scratch.size()>0 && fread(&scratch[0],1,scratch.size(),file)!=scratch.size()))
+    {
+        return(false);
+    }
+    const unsigned char *pos=reinterpret_cast<const unsigned char*>(scratch.empty() ? 0 : &scratch[0]);
+    const unsigned char *stop=pos+scratch.size();
+    bool broken=false;
+    //LEB128, as written by archivewriter::appendvarint
+    auto varint=[&]() -> uint64_t
+    {
+        uint64_t value=0;
+        int shift=0;
+        while(pos<stop && shift<64)
+        {
+            unsigned char byte=*pos++;
+            value|=static_cast<uint64_t>(byte&0x7f)<<shift;
+            if(!(byte&0x80))
+            {
+                return(value);
+            }
+            shift+=7;
+        }
+        broken=true;
+        return(0);
+    };
+
+    last.flags=varint();
+    last.index=varint();
+    last.batchindex=varint();
+    uint64_t mask=varint();
+    for(int i=0;i<9;i++)
+    {
+        if(mask&(1<<i))
+        {
+            if(stop-pos<8)
+            {
+                return(false);
+            }
+            memcpy(&last.params[i],pos,sizeof(double));
+            pos+=sizeof(double);
+        }
+    }
+    std::vector<uint32_t> *sets[2]={&last.coincident,&last.commensurate};
+    for(int set=0;set<2;set++)
+    {
+        uint64_t header=varint();
+        uint64_t count=2*(header>>1);
+        bool relative=header&1;
+        //every value takes at least one byte, more than that can't be in the record.
+        if(header>>1>static_cast<uint64_t>(stop-pos))
+        {
+            return(false);
+        }
+        std::vector<uint32_t> &values=*sets[set];
+        //in relative mode values still holds the previous record, it's overwritten in place, front to back.
+        size_t previoussize=values.size();
+        values.resize(count);
+        int64_t before=0;
+        for(size_t j=0;j<count && !broken;j++)
+        {
+            int64_t base = (relative && j<previoussize) ? values[j] : before;
+            values[j]=static_cast<uint32_t>(base+archivewriter::unzigzag(varint()));
+            before=values[j];
+        }
+    }
+    if(broken)
+    {
+        return(false);
+    }
+    lastindex=k;
+    return(true);
+}
+
+bool archivereader::read(uint64_t k, archiverecord &target)
+{
+    if(!file || k>=offsets.size())
+    {
+        return(false);
+    }
+    if(lastindex!=static_cast<long>(k))
+    {
+        //continue from the last decoded record if that's on the way, otherwise from the keyframe.
+        uint64_t start=k-k%keyinterval;
+        if(lastindex>=static_cast<long>(start) && lastindex<static_cast<long>(k))
+        {
+            start=lastindex+1;
+        }
+        for(uint64_t j=start;j<=k;j++)
+        {
+            if(!decode(j))
+            {
+                lastindex=-1;
+                return(false);
+            }
+        }
+    }
+    target=last;
+    return(true);
+}
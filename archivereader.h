@@ -0,0 +1,73 @@
+/*
+ * LatticeMatch calculator - reading compressed archives
+ * Copyright (C) 2015 Andreas Grois
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ *
+ * Random access to the records of an archive written by archivewriter. The offset table at the end of the
+ * file is read on open(), read(k) then starts decoding at the keyframe before record k. If the records are
+ * read in order, the previous one is reused, so a sequential scan decodes every record only once.
+ *
+ * This class is part of the LatticeMatch program.
+ *
+ * To contact the author either use electronic mail: Andreas Grois <andreas.grois@jku.at>
+ * or write to:
+ * Andreas Grois, Institute for Semiconductor and SolidState physics, Johannes Kepler University,
+ * Altenbergerstraße 69, 4040 Linz, AUSTRIA
+ */
+
+#ifndef ARCHIVEREADER_H
+#define ARCHIVEREADER_H
+
+#include <stdint.h>
+#include <cstdio>
+#include <vector>
+
+//one decoded record
+struct archiverecord
+{
+    uint32_t flags;
+    uint32_t index;
+    uint32_t batchindex;
+    double params[9];
+    std::vector<uint32_t> coincident; //binary angles, lower and upper alternating
+    std::vector<uint32_t> commensurate;
+};
+
+class archivereader
+{
+private:
+    FILE *file;
+    uint32_t keyinterval;
+    std::vector<uint64_t> offsets;
+    uint64_t tableposition;
+    archiverecord last;
+    long lastindex; //-1 if last holds nothing
+    std::vector<char> scratch;
+    bool decode(uint64_t k);
+public:
+    archivereader();
+    ~archivereader();
+
+    //false if the file can't be opened, or isn't an archive
+    bool open(const char *name);
+    void close();
+    uint64_t count() const;
+    //false if k is out of range, or the file is broken
+    bool read(uint64_t k, archiverecord &target);
+};
+
+#endif // ARCHIVEREADER_H
@@ -0,0 +1,233 @@
+/*
+ * LatticeMatch calculator - compressed archive output
+ * Copyright (C) 2015 Andreas Grois
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ *
+ * An archival format for sweeps, delta encoded and packed into variable length integers.
+ * See archivewriter.h for the layout.
+ *
+ * This class is part of the LatticeMatch program.
+ *
+ * To contact the author either use electronic mail: Andreas Grois <andreas.grois@jku.at>
+ * or write to:
+ * Andreas Grois, Institute for Semiconductor and SolidState physics, Johannes Kepler University,
+ * Altenbergerstraße 69, 4040 Linz, AUSTRIA
+ */
+
+#include "archivewriter.h"
+#include "binarywriter.h"
+#include <cstring>
+
+archivewriter::archivewriter(outbuffer &target, uint32_t keyinterval) : out(target)
+{
+    this->keyinterval = keyinterval>0 ? keyinterval : 1;
+    position=0;
+    pendingflags=0;
+    pendingindex=0;
+    batchflags=0;
+    batchindex=0;
+    for(int i=0;i<9;i++)
+    {
+        previousparams[i]=0.0;
+    }
+    uint32_t version=1;
+    emit("LATARCH1",8);
+    emit(reinterpret_cast<const char*>(&version),sizeof(version));
+    emit(reinterpret_cast<const char*>(&this->keyinterval),sizeof(this->keyinterval));
+}
+
+void archivewriter::emit(const char *data, size_t length)
+{
+    out.append(data,length);
+    position+=length;
+}
+
+void archivewriter::appendvarint(std::vector<char> &target, uint64_t value)
+{
+    while(value>=0x80)
+    {
+        target.push_back(static_cast<char>((value&0x7f)|0x80));
+        value>>=7;
+    }
+    target.push_back(static_cast<char>(value));
+}
+
+void archivewriter::emitvarint(uint64_t value)
+{
+    char bytes[10];
+    size_t length=0;
+    while(value>=0x80)
+    {
+        bytes[length++]=static_cast<char>((value&0x7f)|0x80);
+        value>>=7;
+    }
+    bytes[length++]=static_cast<char>(value);
+    emit(bytes,length);
+}
+
+uint64_t archivewriter::zigzag(int64_t value)
+{
+    return((static_cast<uint64_t>(value)<<1)^static_cast<uint64_t>(value>>63));
+}
+
+int64_t archivewriter::unzigzag(uint64_t value)
+{
+    return(static_cast<int64_t>(value>>1)^-static_cast<int64_t>(value&1));
+}
+
+void archivewriter::tovector(angleset &ranges, std::vector<uint32_t> &target)
+{
+    target.clear();
+    const std::vector<anglerange> &storage=ranges.getrangesref();
+    for(std::vector<anglerange>::const_iterator i=storage.begin();i!=storage.end();++i)
+    {
+        if(i->iscircle())
+        {
+            target.push_back(0);
+            target.push_back(0);
+        }
+        else
+        {
+            target.push_back(binarywriter::tobinaryangle(i->getlower(),false));
+            target.push_back(binarywriter::tobinaryangle(i->getupper(),true));
+        }
+    }
+}
+
+void archivewriter::encode(const std::vector<uint32_t> &values, const std::vector<uint32_t> *reference, std::vector<char> &target)
+{
+    target.clear();
+    appendvarint(target,(values.size()/2)<<1 | (reference ? 1 : 0));
+    int64_t before=0;
+    for(size_t j=0;j<values.size();j++)
+    {
+        int64_t base = (reference && j<reference->size()) ? (*reference)[j] : before;
+        appendvarint(target,zigzag(static_cast<int64_t>(values[j])-base));
+        before=values[j];
+    }
+}
+
+void archivewriter::writeextension(double, double)
+{
+    pendingflags=ARC_EXTENSION;
+    pendingindex++;
+}
+
+void archivewriter::writesweeppoint(unsigned int index, double, double)
+{
+    pendingflags=ARC_SWEEP;
+    pendingindex=index;
+}
+
+void archivewriter::writeshell(unsigned int maxindex, bool complete)
+{
+    pendingflags = complete ? ARC_SHELL : ARC_SHELL|ARC_PARTIAL;
+    pendingindex=maxindex;
+}
+
+void archivewriter::writebatchentry(unsigned int index)
+{
+    batchflags=ARC_BATCH;
+    batchindex=index;
+    pendingflags=0;
+    pendingindex=0;
+}
+
+void archivewriter::writeresults(matchsolver &solver)
+{
+    bool keyframe=(offsets.size()%keyinterval)==0;
+    offsets.push_back(position);
+
+    uint32_t flags=pendingflags|batchflags;
+    if(keyframe)
+    {
+        flags|=ARC_KEYFRAME;
+    }
+    if(solver.getloops()==2)
+    {
+        flags|=ARC_HEXAGONAL;
+    }
+    if(solver.getcoincident().iscircle())
+    {
+        flags|=ARC_COINCIDENT_FULLCIRCLE;
+    }
+    if(solver.getcommensurate().iscircle())
+    {
+        flags|=ARC_COMMENSURATE_FULLCIRCLE;
+    }
+    emitvarint(flags);
+    emitvarint(pendingindex);
+    emitvarint(batchindex);
+
+    double params[9];
+    uint64_t mask=0;
+    for(int i=0;i<9;i++)
+    {
+        params[i]=solver.getparam(static_cast<matchsolver::paramnames>(i));
+        if(keyframe || memcmp(&params[i],&previousparams[i],sizeof(double))!=0)
+        {
+            mask|=1<<i;
+        }
+    }
+    emitvarint(mask);
+    for(int i=0;i<9;i++)
+    {
+        if(mask&(1<<i))
+        {
+            emit(reinterpret_cast<const char*>(&params[i]),sizeof(double));
+        }
+        previousparams[i]=params[i];
+    }
+
+    tovector(solver.getcoincident(),current[0]);
+    tovector(solver.getcommensurate(),current[1]);
+    for(int set=0;set<2;set++)
+    {
+        encode(current[set],0,scratch[0]);
+        if(!keyframe)
+        {
+            //relative to the previous sweep point. Only keep it if it's actually shorter.
+            encode(current[set],&previous[set],scratch[1]);
+            if(scratch[1].size()<scratch[0].size())
+            {
+                scratch[0].swap(scratch[1]);
+            }
+        }
+        emit(&scratch[0][0],scratch[0].size());
+        previous[set].swap(current[set]);
+    }
+    out.flushmaybe();
+}
+
+void archivewriter::flush()
+{
+    out.flush();
+}
+
+void archivewriter::finish()
+{
+    uint64_t tableposition=position;
+    for(size_t k=0;k<offsets.size();k++)
+    {
+        emit(reinterpret_cast<const char*>(&offsets[k]),sizeof(uint64_t));
+    }
+    uint64_t count=offsets.size();
+    emit(reinterpret_cast<const char*>(&tableposition),sizeof(uint64_t));
+    emit(reinterpret_cast<const char*>(&count),sizeof(uint64_t));
+    emit("LATARCHE",8);
+    out.flush();
+}
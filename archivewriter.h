@@ -0,0 +1,112 @@
+/*
+ * LatticeMatch calculator - compressed archive output
+ * Copyright (C) 2015 Andreas Grois
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ *
+ * An archival format for sweeps. Neighbouring sweep points give nearly the same ranges, so instead of the
+ * endpoints themselves this stores their differences to the previous record, as variable length integers.
+ * Endpoints are binary angles (2^32 is the full circle, lower rounded down, upper rounded up), so all of this
+ * is exact integer arithmetic.
+ *
+ * Layout:
+ * o) file header: "LATARCH1", uint32 version (1), uint32 keyinterval
+ * o) the records, back to back
+ * o) the offset table: one uint64 per record, the position of the record in the file
+ * o) trailer: uint64 position of the offset table, uint64 number of records, "LATARCHE"
+ * Fixed size numbers are in the byte order of the writing machine, varints are LEB128.
+ *
+ * A record is:
+ * o) varint flags (see archiveflags, the same meaning as binaryflags), varint index, varint batchindex
+ * o) varint mask of the parameters that differ from the previous record, followed by those as raw doubles
+ *    (same order and units as in binaryheader)
+ * o) for the coincident and then the commensurate set: varint (count<<1|mode), followed by 2*count zigzag varints.
+ *    Mode 0: each endpoint relative to the one before it in the same set (the first relative to 0).
+ *    Mode 1: endpoint j relative to endpoint j of the same set in the previous record. If the previous record had
+ *    less endpoints, the surplus ones are relative to the endpoint before them, as in mode 0.
+ *    The writer picks whichever mode is shorter.
+ * Every keyinterval-th record is a keyframe: all parameters present, mode 0 only. To read record k one has to
+ * start decoding at the keyframe before it, which the offset table makes cheap.
+ *
+ * This class is part of the LatticeMatch program.
+ *
+ * To contact the author either use electronic mail: Andreas Grois <andreas.grois@jku.at>
+ * or write to:
+ * Andreas Grois, Institute for Semiconductor and SolidState physics, Johannes Kepler University,
+ * Altenbergerstraße 69, 4040 Linz, AUSTRIA
+ */
+
+#ifndef ARCHIVEWRITER_H
+#define ARCHIVEWRITER_H
+
+#include <stdint.h>
+#include <vector>
+#include "resultwriter.h"
+#include "outbuffer.h"
+
+enum archiveflags
+{
+    ARC_KEYFRAME=1,
+    ARC_HEXAGONAL=2,
+    ARC_COINCIDENT_FULLCIRCLE=4,
+    ARC_COMMENSURATE_FULLCIRCLE=8,
+    ARC_BATCH=16,
+    ARC_SWEEP=32,
+    ARC_EXTENSION=64,
+    ARC_SHELL=128,
+    ARC_PARTIAL=256
+};
+
+class archivewriter : public resultwriter
+{
+private:
+    outbuffer &out;
+    uint32_t keyinterval;
+    uint64_t position; //bytes written so far, for the offset table
+    std::vector<uint64_t> offsets;
+    //the previous record, for the deltas
+    double previousparams[9];
+    std::vector<uint32_t> previous[2];
+    std::vector<uint32_t> current[2];
+    std::vector<char> scratch[2]; //encoded candidates
+    uint32_t pendingflags;
+    uint32_t pendingindex;
+    uint32_t batchflags;
+    uint32_t batchindex;
+
+    void emit(const char *data, size_t length);
+    void emitvarint(uint64_t value);
+    static void tovector(angleset &ranges, std::vector<uint32_t> &target);
+    static void encode(const std::vector<uint32_t> &values, const std::vector<uint32_t> *reference, std::vector<char> &target);
+public:
+    archivewriter(outbuffer &target, uint32_t keyinterval=64);
+
+    void writeextension(double b1max, double b2max);
+    void writesweeppoint(unsigned int index, double b1min, double b1max);
+    void writeshell(unsigned int maxindex, bool complete);
+    void writebatchentry(unsigned int index);
+    void writeresults(matchsolver &solver);
+    void flush();
+    //writes offset table and trailer.
+    void finish();
+
+    //shared with archivereader
+    static void appendvarint(std::vector<char> &target, uint64_t value);
+    static uint64_t zigzag(int64_t value);
+    static int64_t unzigzag(uint64_t value);
+};
+
+#endif // ARCHIVEWRITER_H
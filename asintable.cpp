@@ -0,0 +1,103 @@
+/*
+ * LatticeMatch calculator - tabulated arcsine
+ * Copyright (C) 2015 Andreas Grois
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ *
+ * The generation loops evaluate asin(i*a*sin(alpha)/b) for every index i and every b-limit, and in a sweep
+ * they do so over and over again for the same i and nearby values of b. As the value only depends on the
+ * argument of the arcsine, one table of asin over [0:1] serves all substrates, all indices and all sweep points.
+ *
+ * Values are linearly interpolated. Each cell of the table also stores a rigorous bound for the interpolation
+ * error (plus some ulps for rounding), and lookup() moves the result outwards by that bound, in the direction the
+ * caller asks for. Used for range limits this means the ranges can only get (very slightly) larger, never smaller,
+ * so no match gets lost. Close to |x|=1 the second derivative of asin explodes, there the bound would exceed the
+ * tolerance, and asin is evaluated directly.
+ *
+ * This class is part of the LatticeMatch program.
+ *
+ * To contact the author either use electronic mail: Andreas Grois <andreas.grois@jku.at>
+ * or write to:
+ * Andreas Grois, Institute for Semiconductor and SolidState physics, Johannes Kepler University,
+ * Altenbergerstraße 69, 4040 Linz, AUSTRIA
+ */
+
+#include "asintable.h"
+#include <cmath>
+#include <cfloat>
+
+asintable::asintable(unsigned int cells, double tolerance)
+{
+    this->cells=cells;
+    const double step=1.0/cells;
+    invstep=cells;
+    samples.resize(cells+1);
+    errors.resize(cells);
+    for(unsigned int j=0;j<=cells;j++)
+    {
+        samples[j]=asin(j*step);
+    }
+    //linear interpolation is off by at most step^2/8*max|asin''| inside a cell.
+    //asin''(x)=x/(1-x^2)^(3/2) grows monotonically on [0:1[, so the maximum is at the upper end of the cell.
+    //On top of that: libm's asin is not necessarily correctly rounded, and the interpolation itself rounds a few times.
+    //16 ulps of pi/2 are plenty for that.
+    const double rounding=16.0*DBL_EPSILON*M_PI_2;
+    for(unsigned int j=0;j<cells;j++)
+    {
+        double x=(j+1)*step;
+        double err=-1.0;
+        if(x<1.0)
+        {
+            err=step*step/8.0*x/pow(1.0-x*x,1.5)+rounding;
+            if(err>tolerance)
+            {
+                err=-1.0;
+            }
+        }
+        errors[j]=err;
+    }
+}
+
+double asintable::lookup(double x, int dir) const
+{
+    //asin is odd, so the table only covers positive arguments.
+    double ax=fabs(x);
+    double pos=ax*invstep;
+    if(!(pos<cells)) //also catches NaN
+    {
+        return(asin(x));
+    }
+    unsigned int j=pos;
+    double err=errors[j];
+    if(err<0.0)
+    {
+        //this cell is too close to 1, we need the real thing.
+        return(asin(x));
+    }
+    double t=pos-j;
+    double value=samples[j]+t*(samples[j+1]-samples[j]);
+    if(x<0.0)
+    {
+        value=-value;
+    }
+    return(value+dir*err);
+}
+
+const asintable& asintable::shared()
+{
+    static const asintable table;
+    return(table);
+}
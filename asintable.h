@@ -0,0 +1,62 @@
+/*
+ * LatticeMatch calculator - tabulated arcsine
+ * Copyright (C) 2015 Andreas Grois
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ *
+ * The generation loops evaluate asin(i*a*sin(alpha)/b) for every index i and every b-limit, and in a sweep
+ * they do so over and over again for the same i and nearby values of b. As the value only depends on the
+ * argument of the arcsine, one table of asin over [0:1] serves all substrates, all indices and all sweep points.
+ *
+ * Values are linearly interpolated. Each cell of the table also stores a rigorous bound for the interpolation
+ * error (plus some ulps for rounding), and lookup() moves the result outwards by that bound, in the direction the
+ * caller asks for. Used for range limits this means the ranges can only get (very slightly) larger, never smaller,
+ * so no match gets lost. Close to |x|=1 the second derivative of asin explodes, there the bound would exceed the
+ * tolerance, and asin is evaluated directly.
+ *
+ * This class is part of the LatticeMatch program.
+ *
+ * To contact the author either use electronic mail: Andreas Grois <andreas.grois@jku.at>
+ * or write to:
+ * Andreas Grois, Institute for Semiconductor and SolidState physics, Johannes Kepler University,
+ * Altenbergerstraße 69, 4040 Linz, AUSTRIA
+ */
+
+#ifndef ASINTABLE_H
+#define ASINTABLE_H
+
+#include <vector>
+
+class asintable
+{
+private:
+    std::vector<double> samples; //asin(j*step), j=0..cells
+    std::vector<double> errors; //error bound for cell j, negative if the cell has to be evaluated directly
+    unsigned int cells;
+    double invstep;
+public:
+    //cells should be a power of two, so the sample positions are exact.
+    //tolerance is the largest error (in radians) that is accepted before falling back to asin.
+    asintable(unsigned int cells=32768, double tolerance=1e-9);
+
+    //returns asin(x), moved by the error bound in direction dir (+1: result >= asin(x), -1: result <= asin(x)).
+    double lookup(double x, int dir) const;
+
+    //a process-wide table with the default settings. Built on first use.
+    static const asintable& shared();
+};
+
+#endif // ASINTABLE_H
@@ -0,0 +1,174 @@
+/*
+ * LatticeMatch calculator - the best angle inside each range of matches
+ * Copyright (C) 2015 Andreas Grois
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ *
+ * See bestangle.h.
+ *
+ * This class is part of the LatticeMatch program.
+ *
+ * To contact the author either use electronic mail: Andreas Grois <andreas.grois@jku.at>
+ * or write to:
+ * Andreas Grois, Institute for Semiconductor and SolidState physics, Johannes Kepler University,
+ * Altenbergerstraße 69, 4040 Linz, AUSTRIA
+ */
+
+#include "bestangle.h"
+#include "matchsolver.h"
+#include <cmath>
+
+//Newton steps after each rounding to integers.
+static const int rounds=2, steps=3;
+//how far each entry may change between two starting points, so a start sees at most one other integer.
+static const double spacing=0.25;
+
+//f at sin(theta)=s, cos(theta)=c, with n the integers nearest to the entries there.
+static inline double squares(const double a[4], const double b[4], int count, double s, double c)
+{
+    double f=0.0;
+    for(int k=0;k<count;k++)
+    {
+        const double e=a[k]*s+b[k]*c;
+        const double d=e-floor(e+0.5);
+        f+=d*d;
+    }
+    return(f);
+}
+
+bestangle::bestangle(const double input[9], int loops)
+{
+    const double b1=(input[matchsolver::B1MIN]+input[matchsolver::B1MAX])/2, b2=(input[matchsolver::B2MIN]+input[matchsolver::B2MAX])/2;
+    const double beta=(input[matchsolver::BETAMIN]+input[matchsolver::BETAMAX])/2;
+    for(int l=0;l<loops;l++)
+    {
+        const double alpha=input[matchsolver::ALPHA]+l*M_PI/3.0;
+        const double first=1.0/(input[matchsolver::A1]*sin(alpha)), second=1.0/(input[matchsolver::A2]*sin(alpha));
+        //px, qx, qy, py, expanded with the addition theorem.
+        const double a[4]={-b1*cos(alpha)*first,-b2*cos(alpha-beta)*first,b1*second,b2*cos(beta)*second};
+        const double b[4]={b1*sin(alpha)*first,b2*sin(alpha-beta)*first,0.0,b2*sin(beta)*second};
+        model x={2,{a[0],a[1]},{b[0],b[1]}}, y={2,{a[2],a[3]},{b[2],b[3]}}, both={4,{a[0],a[1],a[2],a[3]},{b[0],b[1],b[2],b[3]}};
+        coincidentmodels.push_back(x);
+        coincidentmodels.push_back(y);
+        commensuratemodels.push_back(both);
+    }
+}
+
+void bestangle::fitmodel(const model &m, const std::vector<double> &lowers, const std::vector<double> &widths,
+                         std::vector<double> &offsets, std::vector<double> &misfits)
+{
+    //no entry changes faster than its amplitude.
+    double fastest=0.0;
+    for(int k=0;k<m.count;k++)
+    {
+        fastest=fmax(fastest,sqrt(m.a[k]*m.a[k]+m.b[k]*m.b[k]));
+    }
+    const double step = fastest>0.0 ? spacing/fastest : 2*M_PI;
+    //the starting points of all ranges, one after the other: the borders, and every step in between. Each
+    //start only looks within a step of itself, where there is one minimum at most for every choice of integers.
+    std::vector<size_t> owner;
+    std::vector<double> at, from, to;
+    for(size_t w=0;w<lowers.size();w++)
+    {
+        const size_t points=static_cast<size_t>(ceil(widths[w]/step));
+        for(size_t k=0;k<=points;k++)
+        {
+            const double start=fmin(widths[w],k*step);
+            owner.push_back(w);
+            at.push_back(start);
+            from.push_back(fmax(0.0,start-step));
+            to.push_back(fmin(widths[w],start+step));
+        }
+    }
+    const size_t count=at.size();
+    std::vector<double> n(4*count,0.0);
+    for(int r=0;r<rounds;r++)
+    {
+        for(size_t p=0;p<count;p++)
+        {
+            const double s=sin(lowers[owner[p]]+at[p]), c=cos(lowers[owner[p]]+at[p]);
+            for(int k=0;k<m.count;k++)
+            {
+                n[4*p+k]=floor(m.a[k]*s+m.b[k]*c+0.5);
+            }
+        }
+        for(int i=0;i<steps;i++)
+        {
+            for(size_t p=0;p<count;p++)
+            {
+                const double s=sin(lowers[owner[p]]+at[p]), c=cos(lowers[owner[p]]+at[p]);
+                //half of f' and f''
+                double slope=0.0, curvature=0.0;
+                for(int k=0;k<m.count;k++)
+                {
+                    const double e=m.a[k]*s+m.b[k]*c, de=m.a[k]*c-m.b[k]*s;
+                    slope+=(e-n[4*p+k])*de;
+                    curvature+=de*de-(e-n[4*p+k])*e;
+                }
+                //not convex here: towards the border it's heading for.
+                const double next = curvature>0.0 ? at[p]-slope/curvature : (slope>0.0 ? from[p] : to[p]);
+                at[p]=fmax(from[p],fmin(to[p],next));
+            }
+        }
+    }
+    offsets.assign(lowers.size(),0.0);
+    misfits.assign(lowers.size(),-1.0);
+    for(size_t p=0;p<count;p++)
+    {
+        //the integers nearest to where it ended, those of the start may not be any more.
+        const double f=squares(m.a,m.b,m.count,sin(lowers[owner[p]]+at[p]),cos(lowers[owner[p]]+at[p]));
+        const double misfit=sqrt(f/m.count);
+        if(misfits[owner[p]]<0.0 || misfit<misfits[owner[p]])
+        {
+            misfits[owner[p]]=misfit;
+            offsets[owner[p]]=at[p];
+        }
+    }
+}
+
+void bestangle::fitall(const std::vector<anglerange> &ranges, bool commensurate, std::vector<fit> &fits) const
+{
+    std::vector<double> lowers, widths;
+    lowers.reserve(ranges.size());
+    widths.reserve(ranges.size());
+    for(std::vector<anglerange>::const_iterator i=ranges.begin();i!=ranges.end();++i)
+    {
+        lowers.push_back(i->iscircle() ? 0.0 : i->getlower().getval());
+        widths.push_back(i->getsize());
+    }
+    fits.assign(ranges.size(),fit());
+    const std::vector<model> &models = commensurate ? commensuratemodels : coincidentmodels;
+    std::vector<double> offsets, misfits;
+    for(size_t m=0;m<models.size();m++)
+    {
+        fitmodel(models[m],lowers,widths,offsets,misfits);
+        for(size_t w=0;w<ranges.size();w++)
+        {
+            if(m==0 || misfits[w]<fits[w].misfit)
+            {
+                fits[w].misfit=misfits[w];
+                fits[w].theta=fmod(lowers[w]+offsets[w],2*M_PI);
+            }
+        }
+    }
+}
+
+bestangle::fit bestangle::fitone(const anglerange &range, bool commensurate) const
+{
+    std::vector<fit> fits;
+    fitall(std::vector<anglerange>(1,range),commensurate,fits);
+    return(fits[0]);
+}
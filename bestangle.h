@@ -0,0 +1,81 @@
+/*
+ * LatticeMatch calculator - the best angle inside each range of matches
+ * Copyright (C) 2015 Andreas Grois
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ *
+ * A range of matches says that somewhere within the windows of b1, b2 and beta the epitaxy matrix is integer,
+ * but not how far the adlayer has to be strained for it. This takes the adlayer as it is on average, with b1,
+ * b2 and beta in the middle of their windows, and looks for the theta inside the range where the matrix is
+ * closest to integers. For that adlayer every entry is a sine of theta,
+ *   e(theta) = A sin(theta) + B cos(theta)
+ * (see thetascan.h for the four of them), so the squared distance of the entries to integers n,
+ *   f(theta) = sum (e(theta) - n)^2
+ * has its first and second derivative in closed form, with e'' = -e. Long adlayer vectors make the entries
+ * large, and f has a minimum for every integer they pass, so a range is started from its borders and from
+ * points in between, spaced so that no entry changes by more than a quarter from one to the next. Each start
+ * rounds the entries to integers, does a few Newton steps within one spacing of itself, rounds again where it
+ * went, and does a few more. Where f is not convex, the step goes to the border it's heading for. The best of
+ * all starts is the result.
+ *
+ * The misfit is the root mean square of e-n at that theta, with the nearest integers n, in multiples of the
+ * substrate vectors. A commensurate range needs all four entries, a coincident one only one column, so that
+ * takes the better of the two. For a hexagonal substrate the better of the two runs counts. The starts of all
+ * ranges are done at once, each Newton step is one pass over all of them, and nothing in a pass depends on
+ * another start.
+ *
+ * This class is part of the LatticeMatch program.
+ *
+ * To contact the author either use electronic mail: Andreas Grois <andreas.grois@jku.at>
+ * or write to:
+ * Andreas Grois, Institute for Semiconductor and SolidState physics, Johannes Kepler University,
+ * Altenbergerstraße 69, 4040 Linz, AUSTRIA
+ */
+
+#ifndef BESTANGLE_H
+#define BESTANGLE_H
+
+#include <vector>
+#include "anglerange.h"
+
+class bestangle
+{
+public:
+    struct fit
+    {
+        double theta; //radians, in [0:2pi)
+        double misfit;
+    };
+private:
+    //the entries of one loop that have to be integers together: 2 for a column, 4 for the whole matrix.
+    struct model
+    {
+        int count;
+        double a[4], b[4];
+    };
+    std::vector<model> coincidentmodels, commensuratemodels;
+    //fits every range for one model. lowers and widths describe the ranges, offsets get theta-lower.
+    static void fitmodel(const model &m, const std::vector<double> &lowers, const std::vector<double> &widths,
+                         std::vector<double> &offsets, std::vector<double> &misfits);
+public:
+    //sanitized parameters, as for matchsolver, and the number of runs (2 for hexagonal substrates, alpha+60 degrees).
+    bestangle(const double input[9], int loops);
+    //a fit for every range, in the same order.
+    void fitall(const std::vector<anglerange> &ranges, bool commensurate, std::vector<fit> &fits) const;
+    fit fitone(const anglerange &range, bool commensurate) const;
+};
+
+#endif // BESTANGLE_H
@@ -0,0 +1,189 @@
+/*
+ * LatticeMatch calculator - binary output
+ * Copyright (C) 2015 Andreas Grois
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ *
+ * Writes results in a compact binary format, meant to be mmap'ed by consumers without any parsing.
+ * See binarywriter.h for the layout.
+ *
+ * This class is part of the LatticeMatch program.
+ *
+ * To contact the author either use electronic mail: Andreas Grois <andreas.grois@jku.at>
+ * or write to:
+ * Andreas Grois, Institute for Semiconductor and SolidState physics, Johannes Kepler University,
+ * Altenbergerstraße 69, 4040 Linz, AUSTRIA
+ */
+
+#include "binarywriter.h"
+#include <cmath>
+#include <cstring>
+
+static_assert(sizeof(binaryheader)==128,"binaryheader has to be exactly 128 bytes, the file format depends on it.");
+
+binarywriter::binarywriter(outbuffer &target, bool binaryangles) : out(target)
+{
+    this->binaryangles=binaryangles;
+    pendingflags=0;
+    pendingindex=0;
+    batchflags=0;
+    batchindex=0;
+}
+
+uint32_t binarywriter::tobinaryangle(const angleclass &angle, bool roundup)
+{
+    //angleclass keeps the value in [0:2pi[, so this is in [0:2^32]. 2^32 itself wraps around to 0.
+    double scaled=angle.getval()*(4294967296.0/(2.0*M_PI));
+    scaled = roundup ? ceil(scaled) : floor(scaled);
+    if(scaled>=4294967296.0)
+    {
+        scaled-=4294967296.0;
+    }
+    return(static_cast<uint32_t>(scaled));
+}
+
+void binarywriter::writeset(const std::vector<anglerange> &ranges)
+{
+    for(std::vector<anglerange>::const_iterator i=ranges.begin();i!=ranges.end();++i)
+    {
+        if(binaryangles)
+        {
+            uint32_t pair[2];
+            if(i->iscircle())
+            {
+                pair[0]=0;
+                pair[1]=0;
+            }
+            else
+            {
+                pair[0]=tobinaryangle(i->getlower(),false);
+                pair[1]=tobinaryangle(i->getupper(),true);
+            }
+            out.append(reinterpret_cast<const char*>(pair),sizeof(pair));
+        }
+        else
+        {
+            double pair[2]={i->getlower().getval(),i->getupper().getval()};
+            out.append(reinterpret_cast<const char*>(pair),sizeof(pair));
+        }
+    }
+}
+
+void binarywriter::writeextension(double, double)
+{
+    pendingflags=BIN_EXTENSION;
+    pendingindex++;
+}
+
+void binarywriter::writesweeppoint(unsigned int index, double, double)
+{
+    pendingflags=BIN_SWEEP;
+    pendingindex=index;
+}
+
+void binarywriter::writeshell(unsigned int maxindex, bool complete)
+{
+    pendingflags = complete ? BIN_SHELL : BIN_SHELL|BIN_PARTIAL;
+    pendingindex=maxindex;
+}
+
+void binarywriter::writebatchentry(unsigned int index)
+{
+    //a batch entry may be followed by sweep points or extensions, those take over the index then.
+    batchflags=BIN_BATCH;
+    batchindex=index;
+    pendingflags=0;
+    pendingindex=0;
+}
+
+void binarywriter::fillheader(matchsolver &solver, binaryheader &header)
+{
+    memset(&header,0,sizeof(header));
+    memcpy(header.magic,"LATMATCH",8);
+    header.version=1;
+    header.headersize=sizeof(header);
+    header.flags=pendingflags|batchflags;
+    if(binaryangles)
+    {
+        header.flags|=BIN_ANGLES;
+    }
+    if(solver.getloops()==2)
+    {
+        header.flags|=BIN_HEXAGONAL;
+    }
+    if(solver.getcoincident().iscircle())
+    {
+        header.flags|=BIN_COINCIDENT_FULLCIRCLE;
+    }
+    if(solver.getcommensurate().iscircle())
+    {
+        header.flags|=BIN_COMMENSURATE_FULLCIRCLE;
+    }
+    header.index=pendingindex;
+    header.batchindex=batchindex;
+    for(int i=0;i<9;i++)
+    {
+        header.params[i]=solver.getparam(static_cast<matchsolver::paramnames>(i));
+    }
+}
+
+void binarywriter::writeresults(matchsolver &solver)
+{
+    const std::vector<anglerange> &coincident=solver.getcoincident().getrangesref();
+    const std::vector<anglerange> &commensurate=solver.getcommensurate().getrangesref();
+
+    binaryheader header;
+    fillheader(solver,header);
+    header.coincidentcount=coincident.size();
+    header.commensuratecount=commensurate.size();
+    size_t pairsize = binaryangles ? 2*sizeof(uint32_t) : 2*sizeof(double);
+    size_t payload=(coincident.size()+commensurate.size())*pairsize;
+    size_t padding=(8-payload%8)%8;
+    header.recordsize=sizeof(header)+payload+padding;
+
+    out.append(reinterpret_cast<const char*>(&header),sizeof(header));
+    writeset(coincident);
+    writeset(commensurate);
+    static const char zeros[8]={0,0,0,0,0,0,0,0};
+    out.append(zeros,padding);
+    out.flushmaybe();
+}
+
+void binarywriter::writeanswer(matchsolver &solver, uint32_t flags, unsigned long answer)
+{
+    binaryheader header;
+    fillheader(solver,header);
+    header.flags|=flags;
+    header.commensuratecount=answer;
+    header.recordsize=sizeof(header);
+    out.append(reinterpret_cast<const char*>(&header),sizeof(header));
+    out.flushmaybe();
+}
+
+void binarywriter::writeexists(matchsolver &solver, bool exists)
+{
+    writeanswer(solver,BIN_QUERY|BIN_EXISTS,exists ? 1 : 0);
+}
+
+void binarywriter::writecount(matchsolver &solver, unsigned long count)
+{
+    writeanswer(solver,BIN_QUERY,count);
+}
+
+void binarywriter::flush()
+{
+    out.flush();
+}
@@ -0,0 +1,114 @@
+/*
+ * LatticeMatch calculator - binary output
+ * Copyright (C) 2015 Andreas Grois
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ *
+ * Writes results in a compact binary format, meant to be mmap'ed by consumers without any parsing.
+ * The file is a sequence of records, one per solve (so a sweep gives one record per point).
+ * Each record is:
+ * o) a binaryheader (128 bytes, see below)
+ * o) coincidentcount pairs of endpoints (lower, upper) of the coincident ranges, sorted by lower
+ * o) commensuratecount pairs of endpoints of the commensurate ranges, sorted by lower
+ * o) zero padding up to a multiple of 8 bytes, so the next header is aligned again.
+ * recordsize in the header is the size of all of this, so consumers can hop from record to record.
+ *
+ * Endpoints are either doubles (radians, in [0:2*pi[), or, with BIN_ANGLES set, binary angles: unsigned 32 bit
+ * integers where 2^32 would be the full circle. Binary angles are rounded outwards (lower down, upper up).
+ * As usual, a range with lower>upper crosses zero. A set that covers the whole circle is stored as a single
+ * range [0:0] and has its FULLCIRCLE flag set.
+ *
+ * Everything is in the byte order of the machine that wrote the file. A reader on a machine with different byte
+ * order will see a version of 0x01000000 instead of 1.
+ *
+ * This class is part of the LatticeMatch program.
+ *
+ * To contact the author either use electronic mail: Andreas Grois <andreas.grois@jku.at>
+ * or write to:
+ * Andreas Grois, Institute for Semiconductor and SolidState physics, Johannes Kepler University,
+ * Altenbergerstraße 69, 4040 Linz, AUSTRIA
+ */
+
+#ifndef BINARYWRITER_H
+#define BINARYWRITER_H
+
+#include <stdint.h>
+#include "resultwriter.h"
+#include "outbuffer.h"
+
+//the header is a plain struct, so consumers can just include this file and cast the mmap'ed pointer.
+struct binaryheader
+{
+    char magic[8];              //"LATMATCH"
+    uint32_t version;           //1
+    uint32_t headersize;        //sizeof(binaryheader), 128
+    uint32_t flags;             //see binaryflags
+    uint32_t index;             //number of the sweep point or extension, largest index for BIN_SHELL, 0 for a plain solve
+    double params[9];           //a1, a2, alpha, b1min, b1max, b2min, b2max, betamin, betamax as used by the solver, radians
+    uint64_t coincidentcount;   //number of coincident ranges
+    uint64_t commensuratecount; //number of commensurate ranges
+    uint64_t recordsize;        //header, both arrays and padding, in bytes
+    uint32_t batchindex;        //number of the entry in a batch file, if BIN_BATCH is set
+    uint32_t reserved;          //zero
+};
+
+enum binaryflags
+{
+    BIN_ANGLES=1,                    //endpoints are uint32 binary angles instead of doubles
+    BIN_HEXAGONAL=2,                 //the substrate was treated as hexagonal (two values for alpha)
+    BIN_EXTENSION=4,                 //this record is the result of an extended window
+    BIN_SWEEP=8,                     //this record is a point of a sweep
+    BIN_COINCIDENT_FULLCIRCLE=16,    //the coincident set is the full circle
+    BIN_COMMENSURATE_FULLCIRCLE=32,  //the commensurate set is the full circle
+    BIN_BATCH=64,                    //this record belongs to an entry of a batch file
+    BIN_SHELL=128,                   //anytime solving: only indices up to index have been looked at
+    BIN_PARTIAL=256,                 //together with BIN_SHELL: the window allows larger indices, they were left out
+    BIN_QUERY=512,                   //a query answer: no endpoints, commensuratecount holds the number of commensurate ranges
+    BIN_EXISTS=1024,                 //together with BIN_QUERY: the question was if there are any, commensuratecount is 1 or 0
+    BIN_TRUNCATED=2048               //shared memory only: the record didn't fit into a slot, the counts say what's left
+};
+
+class binarywriter : public resultwriter
+{
+private:
+    outbuffer &out;
+    bool binaryangles;
+    uint32_t pendingflags; //set by writeextension/writesweeppoint for the next record
+    uint32_t pendingindex;
+    uint32_t batchflags;
+    uint32_t batchindex;
+    void writeset(const std::vector<anglerange> &ranges);
+    //everything but the counts and the size
+    void fillheader(matchsolver &solver, binaryheader &header);
+    //a record without endpoints
+    void writeanswer(matchsolver &solver, uint32_t flags, unsigned long answer);
+public:
+    binarywriter(outbuffer &target, bool binaryangles=false);
+
+    void writeextension(double b1max, double b2max);
+    void writesweeppoint(unsigned int index, double b1min, double b1max);
+    void writeshell(unsigned int maxindex, bool complete);
+    void writebatchentry(unsigned int index);
+    void writeresults(matchsolver &solver);
+    void writeexists(matchsolver &solver, bool exists);
+    void writecount(matchsolver &solver, unsigned long count);
+    void flush();
+
+    //converts an angle to a binary angle, rounding down or up.
+    static uint32_t tobinaryangle(const angleclass &angle, bool roundup);
+};
+
+#endif // BINARYWRITER_H
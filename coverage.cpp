@@ -0,0 +1,182 @@
+/*
+ * LatticeMatch calculator - how many index combinations hit each theta
+ * Copyright (C) 2015 Andreas Grois
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ *
+ * See coverage.h.
+ *
+ * This class is part of the LatticeMatch program.
+ *
+ * To contact the author either use electronic mail: Andreas Grois <andreas.grois@jku.at>
+ * or write to:
+ * Andreas Grois, Institute for Semiconductor and SolidState physics, Johannes Kepler University,
+ * Altenbergerstraße 69, 4040 Linz, AUSTRIA
+ */
+
+#include "coverage.h"
+#include <cmath>
+#include <algorithm>
+
+bool coverage::piece::operator<(const piece &other) const
+{
+    return(index<other.index || (index==other.index && lower<other.lower));
+}
+
+bool coverage::border::operator<(const border &other) const
+{
+    return(angle<other.angle);
+}
+
+coverage::coverage()
+{
+    valid=false;
+}
+
+void coverage::clear()
+{
+    borders.clear();
+    coincidentsteps.clear();
+    commensuratesteps.clear();
+    valid=false;
+}
+
+void coverage::cut(const std::vector<anglerange> &ranges, const std::vector<int> &indices, int family, int loop)
+{
+    std::vector<piece> pieces;
+    pieces.reserve(ranges.size()+2);
+    for(size_t k=0;k<ranges.size() && k<indices.size();k++)
+    {
+        const anglerange &range=ranges[k];
+        if(range.isempty())
+        {
+            continue;
+        }
+        piece p;
+        p.index=indices[k];
+        p.lower=range.getlower().getval();
+        p.upper=range.getupper().getval();
+        if(range.iscircle())
+        {
+            p.lower=0.0;
+            p.upper=2*M_PI;
+        }
+        if(p.lower>p.upper)
+        {
+            //[lower:2pi] and [0:upper]
+            const double upper=p.upper;
+            p.upper=2*M_PI;
+            pieces.push_back(p);
+            p.lower=0.0;
+            p.upper=upper;
+        }
+        pieces.push_back(p);
+    }
+    //an index counts once, even where two of its ranges overlap.
+    std::sort(pieces.begin(),pieces.end());
+    for(size_t k=0;k<pieces.size();)
+    {
+        border start={pieces[k].lower,loop,family,1}, end={pieces[k].upper,loop,family,-1};
+        for(k++;k<pieces.size() && pieces[k].index==pieces[k-1].index && pieces[k].lower<=end.angle;k++)
+        {
+            end.angle=std::max(end.angle,pieces[k].upper);
+        }
+        borders.push_back(start);
+        borders.push_back(end);
+    }
+}
+
+void coverage::addloop(int loop, const std::vector<anglerange> &px, const std::vector<int> &pxindices,
+                       const std::vector<anglerange> &qx, const std::vector<int> &qxindices,
+                       const std::vector<anglerange> &qy, const std::vector<int> &qyindices,
+                       const std::vector<anglerange> &py, const std::vector<int> &pyindices)
+{
+    borders.reserve(borders.size()+2*(px.size()+qx.size()+qy.size()+py.size()));
+    cut(px,pxindices,0,loop);
+    cut(qx,qxindices,1,loop);
+    cut(qy,qyindices,2,loop);
+    cut(py,pyindices,3,loop);
+}
+
+void coverage::addstep(std::vector<step> &steps, double lower, double upper, unsigned long long count)
+{
+    if(count==0)
+    {
+        return;
+    }
+    if(!steps.empty() && steps.back().upper==lower && steps.back().count==count)
+    {
+        steps.back().upper=upper;
+        return;
+    }
+    step s={lower,upper,count};
+    steps.push_back(s);
+}
+
+void coverage::jointhroughzero(std::vector<step> &steps)
+{
+    if(steps.size()>=2 && steps.front().lower==0.0 && steps.back().upper==2*M_PI && steps.front().count==steps.back().count)
+    {
+        steps.back().upper=steps.front().upper;
+        steps.erase(steps.begin());
+    }
+}
+
+void coverage::finish()
+{
+    std::sort(borders.begin(),borders.end());
+    //how many ranges of each family theta is in, per loop.
+    long inside[2][4]={{0,0,0,0},{0,0,0,0}};
+    coincidentsteps.clear();
+    commensuratesteps.clear();
+    for(size_t k=0;k<borders.size();)
+    {
+        //everything that starts or ends here, then the counts hold up to the next border.
+        const double at=borders[k].angle;
+        for(;k<borders.size() && borders[k].angle==at;k++)
+        {
+            inside[borders[k].loop][borders[k].family]+=borders[k].delta;
+        }
+        if(k==borders.size())
+        {
+            break;
+        }
+        unsigned long long coincident=0, commensurate=0;
+        for(int loop=0;loop<2;loop++)
+        {
+            const unsigned long long px=inside[loop][0], qx=inside[loop][1], qy=inside[loop][2], py=inside[loop][3];
+            coincident+=px*qx+qy*py;
+            commensurate+=px*qx*qy*py;
+        }
+        addstep(coincidentsteps,at,borders[k].angle,coincident);
+        addstep(commensuratesteps,at,borders[k].angle,commensurate);
+    }
+    jointhroughzero(coincidentsteps);
+    jointhroughzero(commensuratesteps);
+    borders.clear();
+    borders.shrink_to_fit();
+    valid=true;
+}
+
+bool coverage::isvalid() const
+{
+    return(valid);
+}
+
+const std::vector<coverage::step>& coverage::getsteps(bool commensurate) const
+{
+    return(commensurate ? commensuratesteps : coincidentsteps);
+}
@@ -0,0 +1,104 @@
+/*
+ * LatticeMatch calculator - how many index combinations hit each theta
+ * Copyright (C) 2015 Andreas Grois
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ *
+ * Consolidating a family forgets how many ranges were on top of each other. This class counts them instead:
+ * it gets the four families of each loop as they were generated, and goes around the circle once over all
+ * their borders, sorted, keeping the number of px, qx, qy and py indices theta is in. Each index has two ranges
+ * per sign, which overlap where the asin is clamped at 90 degrees, so the ranges of one index are joined up
+ * first, with the indices the solver records for provenance. Between two borders
+ *   coincident:   px*qx + qy*py
+ *   commensurate: px*qx*qy*py
+ * is the number of index combinations (n, m), (o, p) or (n, m, o, p) that match there, summed over the loops.
+ * A theta that many combinations hit is a robust match, one that a single pair only just reaches is not.
+ *
+ * The result is a piecewise constant function: a list of steps, each with the count on it, sorted, and
+ * neighbours with the same count joined. Steps with a count of 0 are left out, so the steps cover the results
+ * of a solve without a minimum width, apart from single angles. The counts are those of the open intervals
+ * between two borders: ranges of zero width (index 0 of px and qy) don't count, single angles are not steps.
+ * Ranges through 0 are cut in two, and a step going through 0 is joined up again, with its lower border above
+ * the upper one, like the ranges of an angleset. Sorting the borders is what it costs, O(n log n) in the
+ * number of ranges.
+ *
+ * This class is part of the LatticeMatch program.
+ *
+ * To contact the author either use electronic mail: Andreas Grois <andreas.grois@jku.at>
+ * or write to:
+ * Andreas Grois, Institute for Semiconductor and SolidState physics, Johannes Kepler University,
+ * Altenbergerstraße 69, 4040 Linz, AUSTRIA
+ */
+
+#ifndef COVERAGE_H
+#define COVERAGE_H
+
+#include <vector>
+#include "angleset.h"
+
+class coverage
+{
+public:
+    //theta in [lower:upper] (radians) is hit by count combinations.
+    struct step
+    {
+        double lower, upper;
+        unsigned long long count;
+    };
+private:
+    //a range of one index that doesn't go through 0.
+    struct piece
+    {
+        double lower, upper;
+        int index;
+        bool operator<(const piece &other) const;
+    };
+    //a border of what the pieces of one index cover. delta is +1 where it starts, -1 where it ends.
+    struct border
+    {
+        double angle;
+        int loop;
+        int family; //0 px, 1 qx, 2 qy, 3 py
+        int delta;
+        bool operator<(const border &other) const;
+    };
+    std::vector<border> borders;
+    std::vector<step> coincidentsteps, commensuratesteps;
+    bool valid;
+
+    //the ranges of one family, joined up index by index, as borders.
+    void cut(const std::vector<anglerange> &ranges, const std::vector<int> &indices, int family, int loop);
+    //appends [lower:upper] to steps, or makes the last step longer if it ends there and has the same count.
+    static void addstep(std::vector<step> &steps, double lower, double upper, unsigned long long count);
+    //the first and the last step become one, if they meet at 0 and have the same count.
+    static void jointhroughzero(std::vector<step> &steps);
+public:
+    coverage();
+    void clear();
+    //the families of one loop as they were generated, before any consolidation, and the index of each range.
+    //loop is 0 or 1.
+    void addloop(int loop, const std::vector<anglerange> &px, const std::vector<int> &pxindices,
+                 const std::vector<anglerange> &qx, const std::vector<int> &qxindices,
+                 const std::vector<anglerange> &qy, const std::vector<int> &qyindices,
+                 const std::vector<anglerange> &py, const std::vector<int> &pyindices);
+    //after all loops: sorts the borders, counts, and drops them.
+    void finish();
+    //false if nothing has been finished since the last clear().
+    bool isvalid() const;
+    const std::vector<step>& getsteps(bool commensurate) const;
+};
+
+#endif // COVERAGE_H
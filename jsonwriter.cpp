@@ -0,0 +1,317 @@
+/*
+ * LatticeMatch calculator - JSON Lines output
+ * Copyright (C) 2015 Andreas Grois
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ *
+ * Writes one self-contained JSON object per solve, one object per line. See jsonwriter.h for the layout.
+ *
+ * This class is part of the LatticeMatch program.
+ *
+ * To contact the author either use electronic mail: Andreas Grois <andreas.grois@jku.at>
+ * or write to:
+ * Andreas Grois, Institute for Semiconductor and SolidState physics, Johannes Kepler University,
+ * Altenbergerstraße 69, 4040 Linz, AUSTRIA
+ */
+
+#include "jsonwriter.h"
+#include <cmath>
+
+jsonwriter::jsonwriter(outbuffer &target) : out(target)
+{
+    batchindex=-1;
+    sweepindex=-1;
+    extensionindex=-1;
+    shellindex=-1;
+    shellcomplete=false;
+}
+
+void jsonwriter::writeset(angleset &ranges)
+{
+    out.append('[');
+    if(ranges.iscircle())
+    {
+        out.append("[0,360]");
+    }
+    else
+    {
+        const std::vector<anglerange> &storage=ranges.getrangesref();
+        for(std::vector<anglerange>::const_iterator i=storage.begin();i!=storage.end();++i)
+        {
+            if(i!=storage.begin())
+            {
+                out.append(',');
+            }
+            writerange(*i);
+        }
+    }
+    out.append(']');
+}
+
+void jsonwriter::writerange(const anglerange &range)
+{
+    if(range.iscircle())
+    {
+        out.append("[0,360]");
+        return;
+    }
+    out.append('[');
+    out.appendshortest(range.getlower().getval()*180/M_PI);
+    out.append(',');
+    out.appendshortest(range.getupper().getval()*180/M_PI);
+    out.append(']');
+}
+
+void jsonwriter::writelabels(angleset &ranges, const provenance &labels, bool commensurate)
+{
+    size_t count = ranges.iscircle() ? 1 : ranges.getrangesref().size();
+    out.append('[');
+    for(size_t k=0;k<count;k++)
+    {
+        out.append(k>0 ? ",[" : "[");
+        const epitaxymatrix *matrices=labels.labels(commensurate,k);
+        for(size_t j=0;j<labels.count(commensurate,k);j++)
+        {
+            const int entries[5]={matrices[j].px,matrices[j].qx,matrices[j].qy,matrices[j].py,matrices[j].loop};
+            out.append(j>0 ? ",[" : "[");
+            for(int i=0;i<5;i++)
+            {
+                if(i>0)
+                {
+                    out.append(',');
+                }
+                if(entries[i]==provenance::FREE)
+                {
+                    out.append("null");
+                    continue;
+                }
+                if(entries[i]<0)
+                {
+                    out.append('-');
+                }
+                out.appendu(entries[i]<0 ? -static_cast<long long>(entries[i]) : entries[i]);
+            }
+            out.append(']');
+        }
+        out.append(']');
+    }
+    out.append(']');
+}
+
+void jsonwriter::writeorders(const std::vector<unsigned int> &orders)
+{
+    out.append('[');
+    for(size_t k=0;k<orders.size();k++)
+    {
+        if(k>0)
+        {
+            out.append(',');
+        }
+        out.appendu(orders[k]);
+    }
+    out.append(']');
+}
+
+void jsonwriter::writesteps(const std::vector<coverage::step> &steps)
+{
+    out.append('[');
+    for(std::vector<coverage::step>::const_iterator i=steps.begin();i!=steps.end();++i)
+    {
+        out.append(i!=steps.begin() ? ",[" : "[");
+        out.appendshortest(i->lower*180/M_PI);
+        out.append(',');
+        out.appendshortest(i->upper*180/M_PI);
+        out.append(',');
+        out.appendu(i->count);
+        out.append(']');
+    }
+    out.append(']');
+}
+
+void jsonwriter::writefits(const std::vector<bestangle::fit> &fits)
+{
+    out.append('[');
+    for(std::vector<bestangle::fit>::const_iterator i=fits.begin();i!=fits.end();++i)
+    {
+        out.append(i!=fits.begin() ? ",[" : "[");
+        out.appendshortest(i->theta*180/M_PI);
+        out.append(',');
+        out.appendshortest(i->misfit);
+        out.append(']');
+    }
+    out.append(']');
+}
+
+void jsonwriter::writeindices()
+{
+    out.append('{');
+    if(batchindex>=0)
+    {
+        out.append("\"batch\":");
+        out.appendu(batchindex);
+        out.append(',');
+    }
+    if(sweepindex>=0)
+    {
+        out.append("\"sweep\":");
+        out.appendu(sweepindex);
+        out.append(',');
+    }
+    if(extensionindex>=0)
+    {
+        out.append("\"extension\":");
+        out.appendu(extensionindex+1);
+        out.append(',');
+    }
+    if(shellindex>=0)
+    {
+        out.append("\"shell\":");
+        out.appendu(shellindex);
+        out.append(shellcomplete ? ",\"complete\":true," : ",\"complete\":false,");
+    }
+}
+
+void jsonwriter::writeextension(double, double)
+{
+    extensionindex++;
+}
+
+void jsonwriter::writesweeppoint(unsigned int index, double, double)
+{
+    sweepindex=index;
+}
+
+void jsonwriter::writeshell(unsigned int maxindex, bool complete)
+{
+    shellindex=maxindex;
+    shellcomplete=complete;
+}
+
+void jsonwriter::writebatchentry(unsigned int index)
+{
+    batchindex=index;
+    sweepindex=-1;
+    extensionindex=-1;
+    shellindex=-1;
+}
+
+void jsonwriter::writeinputs(matchsolver &solver)
+{
+    static const char *names[9]={"a1","a2","alpha","b1min","b1max","b2min","b2max","betamin","betamax"};
+    //the angles go out in degrees, like everything else the user sees.
+    static const bool isangle[9]={false,false,true,false,false,false,false,true,true};
+
+    out.append("\"inputs\":{");
+    for(int i=0;i<9;i++)
+    {
+        if(i>0)
+        {
+            out.append(',');
+        }
+        out.append('"');
+        out.append(names[i]);
+        out.append("\":");
+        double value=solver.getparam(static_cast<matchsolver::paramnames>(i));
+        out.appendshortest(isangle[i] ? value*180/M_PI : value);
+    }
+    out.append("},\"hexagonal\":");
+    out.append(solver.getloops()==2 ? "true" : "false");
+}
+
+void jsonwriter::writeend(matchsolver &solver)
+{
+    out.append(",\"time\":");
+    out.appendshortest(solver.getsolvetime());
+    out.append("}\n");
+    //streaming: the record goes out now, not when the buffer happens to be full.
+    out.flush();
+}
+
+void jsonwriter::writeresults(matchsolver &solver)
+{
+    writeindices();
+    writeinputs(solver);
+    out.append(",\"coincident\":");
+    writeset(solver.getcoincident());
+    out.append(",\"commensurate\":");
+    writeset(solver.getcommensurate());
+    const provenance &labels=solver.getprovenance();
+    if(labels.isvalid())
+    {
+        out.append(",\"coincidentmatrices\":");
+        writelabels(solver.getcoincident(),labels,false);
+        out.append(",\"commensuratematrices\":");
+        writelabels(solver.getcommensurate(),labels,true);
+    }
+    if(!solver.getorders(false).empty() || !solver.getorders(true).empty())
+    {
+        out.append(",\"coincidentorders\":");
+        writeorders(solver.getorders(false));
+        out.append(",\"commensurateorders\":");
+        writeorders(solver.getorders(true));
+    }
+    if(!solver.getfits(false).empty() || !solver.getfits(true).empty())
+    {
+        out.append(",\"coincidentbest\":");
+        writefits(solver.getfits(false));
+        out.append(",\"commensuratebest\":");
+        writefits(solver.getfits(true));
+    }
+    const coverage &multiplicity=solver.getcoverage();
+    if(multiplicity.isvalid())
+    {
+        out.append(",\"coincidentmultiplicity\":");
+        writesteps(multiplicity.getsteps(false));
+        out.append(",\"commensuratemultiplicity\":");
+        writesteps(multiplicity.getsteps(true));
+    }
+    writeend(solver);
+}
+
+void jsonwriter::writeexists(matchsolver &solver, bool exists)
+{
+    writeindices();
+    writeinputs(solver);
+    out.append(exists ? ",\"exists\":true" : ",\"exists\":false");
+    writeend(solver);
+}
+
+void jsonwriter::writecount(matchsolver &solver, unsigned long count)
+{
+    writeindices();
+    writeinputs(solver);
+    out.append(",\"count\":");
+    out.appendu(count);
+    writeend(solver);
+}
+
+void jsonwriter::writefinalrange(bool commensurate, const anglerange &range)
+{
+    writeindices();
+    out.append(commensurate ? "\"commensurate\":" : "\"coincident\":");
+    writerange(range);
+    out.append("}\n");
+}
+
+void jsonwriter::writesectordone()
+{
+    out.flush();
+}
+
+void jsonwriter::flush()
+{
+    out.flush();
+}
@@ -0,0 +1,105 @@
+/*
+ * LatticeMatch calculator - JSON Lines output
+ * Copyright (C) 2015 Andreas Grois
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ *
+ * Writes one self-contained JSON object per solve, one object per line, and flushes after each of them,
+ * so whoever reads the other end of the pipe can start working right away.
+ * The text is written straight into the output buffer, there is no document object in between.
+ *
+ * A record looks like this (without the line breaks):
+ * {"batch":0,"sweep":3,"extension":0,
+ *  "inputs":{"a1":2.46,"a2":2.46,"alpha":60,"b1min":4.9,"b1max":5.1,"b2min":4.9,"b2max":5.1,"betamin":55,"betamax":65},
+ *  "hexagonal":true,
+ *  "coincident":[[56.66,63.33],...],
+ *  "commensurate":[[0,0],...],
+ *  "time":0.000123}
+ * "batch", "sweep" and "extension" are only there if the record belongs to one. Anytime solving adds
+ * "shell":16,"complete":false after them (indices up to 16, and the window would allow larger ones).
+ * Angles are in degrees, with full round-trip precision. A set covering the full circle is written as
+ * [[0,360]]. time is the wall clock time of the solve, in seconds.
+ *
+ * The query modes replace "coincident" and "commensurate" by "exists":true or "count":12.
+ *
+ * With provenance (see matchsolver::setprovenance()) there are "coincidentmatrices" and "commensuratematrices"
+ * after the ranges: one list per range, in the same order, of [px,qx,qy,py,loop], null for a free entry.
+ * loop is 1 for the second run of a hexagonal substrate, see provenance.h.
+ *
+ * With a maximum order above 1 (see matchsolver::setmaxorder()) there are "coincidentorders" and
+ * "commensurateorders" instead: one number per range, the smallest denominator of the entries it needs.
+ *
+ * With best angles (see matchsolver::setbestangles()) "coincidentbest" and "commensuratebest" follow, one
+ * [theta,misfit] per range, see bestangle.h.
+ *
+ * With coverage counting (see matchsolver::setcoverage()) "coincidentmultiplicity" and "commensuratemultiplicity"
+ * come last, each a list of [lower,upper,count] steps, see coverage.h.
+ *
+ * When streaming (see matchsolver::solve(sectors, sink)) each final range gets a record of its own instead,
+ * as soon as it's known: {"batch":0,"sweep":3,"coincident":[56.66,63.33]} or {...,"commensurate":[0,0]}.
+ *
+ * This class is part of the LatticeMatch program.
+ *
+ * To contact the author either use electronic mail: Andreas Grois <andreas.grois@jku.at>
+ * or write to:
+ * Andreas Grois, Institute for Semiconductor and SolidState physics, Johannes Kepler University,
+ * Altenbergerstraße 69, 4040 Linz, AUSTRIA
+ */
+
+#ifndef JSONWRITER_H
+#define JSONWRITER_H
+
+#include "resultwriter.h"
+#include "outbuffer.h"
+
+class jsonwriter : public resultwriter, public matchsink
+{
+private:
+    outbuffer &out;
+    int batchindex; //-1 if not set
+    int sweepindex;
+    int extensionindex;
+    int shellindex;
+    bool shellcomplete;
+    void writeset(angleset &ranges);
+    void writerange(const anglerange &range);
+    void writelabels(angleset &ranges, const provenance &labels, bool commensurate);
+    void writeorders(const std::vector<unsigned int> &orders);
+    void writesteps(const std::vector<coverage::step> &steps);
+    void writefits(const std::vector<bestangle::fit> &fits);
+    //opens a record, and writes the keys telling where it belongs
+    void writeindices();
+    //the "inputs" and "hexagonal" keys
+    void writeinputs(matchsolver &solver);
+    //"time", and closes the record
+    void writeend(matchsolver &solver);
+public:
+    jsonwriter(outbuffer &target);
+
+    void writeextension(double b1max, double b2max);
+    void writesweeppoint(unsigned int index, double b1min, double b1max);
+    void writeshell(unsigned int maxindex, bool complete);
+    void writebatchentry(unsigned int index);
+    void writeresults(matchsolver &solver);
+    void writeexists(matchsolver &solver, bool exists);
+    void writecount(matchsolver &solver, unsigned long count);
+    void flush();
+
+    void writefinalrange(bool commensurate, const anglerange &range);
+    void writesectordone();
+};
+
+#endif // JSONWRITER_H
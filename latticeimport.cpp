@@ -0,0 +1,501 @@
+/*
+ * LatticeMatch calculator - importing lattices from crystallographic files
+ * Copyright (C) 2015 Andreas Grois
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ *
+ * Reads CIF and POSCAR files and reduces lattice planes to 2D cells. See latticeimport.h.
+ *
+ * This class is part of the LatticeMatch program.
+ *
+ * To contact the author either use electronic mail: Andreas Grois <andreas.grois@jku.at>
+ * or write to:
+ * Andreas Grois, Institute for Semiconductor and SolidState physics, Johannes Kepler University,
+ * Altenbergerstraße 69, 4040 Linz, AUSTRIA
+ */
+
+#include "latticeimport.h"
+#include <iostream>
+#include <cmath>
+#include <cstring>
+#include <cstdlib>
+#include <cctype>
+#include <algorithm>
+#include <strings.h>
+#include <thread>
+#include <atomic>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+//the next line of a mapped file, without the line break. false at the end.
+static bool nextline(const char *&pos, const char *end, const char *&line, size_t &length)
+{
+    if(pos>=end)
+    {
+        return(false);
+    }
+    line=pos;
+    const char *stop=static_cast<const char*>(memchr(pos,'\n',end-pos));
+    if(!stop)
+    {
+        stop=end;
+    }
+    length=stop-line;
+    if(length>0 && line[length-1]=='\r')
+    {
+        length--;
+    }
+    pos = stop<end ? stop+1 : end;
+    return(true);
+}
+
+//copies the next whitespace separated token of a line into target, zero terminated (and cut if it doesn't fit).
+//The mapped file isn't zero terminated, so strtod and friends only ever see these copies.
+static bool nexttoken(const char *&pos, const char *end, char *target, size_t size)
+{
+    while(pos<end && (*pos==' ' || *pos=='\t'))
+    {
+        pos++;
+    }
+    if(pos>=end)
+    {
+        return(false);
+    }
+    size_t used=0;
+    while(pos<end && *pos!=' ' && *pos!='\t')
+    {
+        if(used+1<size)
+        {
+            target[used++]=*pos;
+        }
+        pos++;
+    }
+    target[used]='\0';
+    return(true);
+}
+
+//g=gcd(a,b)>=0 with p*a+q*b=g
+static long extendedgcd(long a, long b, long &p, long &q)
+{
+    long oldr=a, r=b, oldp=1, newp=0, oldq=0, newq=1;
+    while(r!=0)
+    {
+        long quotient=oldr/r;
+        long swap=oldr-quotient*r; oldr=r; r=swap;
+        swap=oldp-quotient*newp; oldp=newp; newp=swap;
+        swap=oldq-quotient*newq; oldq=newq; newq=swap;
+    }
+    if(oldr<0)
+    {
+        oldr=-oldr; oldp=-oldp; oldq=-oldq;
+    }
+    p=oldp;
+    q=oldq;
+    return(oldr);
+}
+
+static double dot(const double a[3], const double b[3])
+{
+    return(a[0]*b[0]+a[1]*b[1]+a[2]*b[2]);
+}
+
+bool latticeimport::readcif(const char *data, size_t length, lattice &target)
+{
+    static const char *tags[6]={"_cell_length_a","_cell_length_b","_cell_length_c","_cell_angle_alpha","_cell_angle_beta","_cell_angle_gamma"};
+    double cell[6];
+    int found=0;
+    char centering='P';
+    bool indata=false;
+    const char *pos=data, *end=data+length, *line;
+    size_t linelength;
+    char token[128];
+    while(nextline(pos,end,line,linelength))
+    {
+        const char *linepos=line, *lineend=line+linelength;
+        if(!nexttoken(linepos,lineend,token,sizeof(token)))
+        {
+            continue;
+        }
+        if(strncasecmp(token,"data_",5)==0)
+        {
+            //only the first block counts.
+            if(indata)
+            {
+                break;
+            }
+            indata=true;
+            continue;
+        }
+        if(token[0]!='_')
+        {
+            continue;
+        }
+        int tag;
+        for(tag=0;tag<6 && strcasecmp(token,tags[tag])!=0;tag++);
+        if(tag<6)
+        {
+            //the uncertainty in brackets, as in 5.4307(2), ends the number for strtod.
+            if(nexttoken(linepos,lineend,token,sizeof(token)))
+            {
+                char *stop;
+                cell[tag]=strtod(token,&stop);
+                if(stop!=token)
+                {
+                    found|=1<<tag;
+                }
+            }
+        }
+        else if(strcasecmp(token,"_symmetry_space_group_name_H-M")==0 || strcasecmp(token,"_space_group_name_H-M_alt")==0)
+        {
+            //quoted, and with spaces in between, like 'F m -3 m'. Only the first letter is of interest.
+            for(;linepos<lineend && !isalpha(static_cast<unsigned char>(*linepos));linepos++);
+            if(linepos<lineend)
+            {
+                centering=toupper(static_cast<unsigned char>(*linepos));
+            }
+        }
+    }
+    if(found!=63)
+    {
+        target.error="cell parameters missing";
+        return(false);
+    }
+    double cosalpha=cos(cell[3]*M_PI/180.0), cosbeta=cos(cell[4]*M_PI/180.0), cosgamma=cos(cell[5]*M_PI/180.0), singamma=sin(cell[5]*M_PI/180.0);
+    double cy=(cosalpha-cosbeta*cosgamma)/singamma;
+    double cz2=1.0-cosbeta*cosbeta-cy*cy;
+    if(cell[0]<=0.0 || cell[1]<=0.0 || cell[2]<=0.0 || cz2<=0.0)
+    {
+        target.error="cell parameters don't give a lattice";
+        return(false);
+    }
+    double conventional[3][3]={{cell[0],0.0,0.0},{cell[1]*cosgamma,cell[1]*singamma,0.0},{cell[2]*cosbeta,cell[2]*cy,cell[2]*sqrt(cz2)}};
+
+    //primitive vectors, in fractions of the conventional ones. R only in the hexagonal setting, the rhombohedral one is primitive already.
+    static const double primitive[7][3][3]=
+    {
+        {{1,0,0},{0,1,0},{0,0,1}},
+        {{0,0.5,0.5},{0.5,0,0.5},{0.5,0.5,0}},
+        {{-0.5,0.5,0.5},{0.5,-0.5,0.5},{0.5,0.5,-0.5}},
+        {{0.5,-0.5,0},{0.5,0.5,0},{0,0,1}},
+        {{1,0,0},{0,0.5,-0.5},{0,0.5,0.5}},
+        {{0.5,0,-0.5},{0,1,0},{0.5,0,0.5}},
+        {{2.0/3.0,1.0/3.0,1.0/3.0},{-1.0/3.0,1.0/3.0,1.0/3.0},{-1.0/3.0,-2.0/3.0,1.0/3.0}}
+    };
+    const char *letters="PFICABR";
+    const char *letter=strchr(letters,centering);
+    int which = letter ? letter-letters : 0;
+    if(centering=='R' && fabs(cell[5]-120.0)>1e-3)
+    {
+        which=0;
+    }
+    for(int i=0;i<3;i++)
+    {
+        for(int j=0;j<3;j++)
+        {
+            target.vectors[i][j]=0.0;
+            for(int n=0;n<3;n++)
+            {
+                target.vectors[i][j]+=primitive[which][i][n]*conventional[n][j];
+            }
+            //an index of the primitive cell is the plane normal dotted with a primitive vector.
+            target.tomiller[i][j]=primitive[which][i][j];
+        }
+    }
+    return(true);
+}
+
+bool latticeimport::readposcar(const char *data, size_t length, lattice &target)
+{
+    const char *pos=data, *end=data+length, *line;
+    size_t linelength;
+    char token[128];
+    double scale=0.0;
+    //comment, scale, three vectors
+    for(int n=0;n<5;n++)
+    {
+        if(!nextline(pos,end,line,linelength))
+        {
+            target.error="file ends before the lattice vectors";
+            return(false);
+        }
+        const char *linepos=line, *lineend=line+linelength;
+        if(n==0)
+        {
+            continue;
+        }
+        for(int j=0;j<(n==1 ? 1 : 3);j++)
+        {
+            char *stop=token;
+            double value=0.0;
+            if(nexttoken(linepos,lineend,token,sizeof(token)))
+            {
+                value=strtod(token,&stop);
+            }
+            if(stop==token)
+            {
+                target.error="lattice vectors unreadable";
+                return(false);
+            }
+            if(n==1)
+            {
+                scale=value;
+            }
+            else
+            {
+                target.vectors[n-2][j]=value;
+            }
+        }
+    }
+    double cross[3]={target.vectors[1][1]*target.vectors[2][2]-target.vectors[1][2]*target.vectors[2][1],
+                     target.vectors[1][2]*target.vectors[2][0]-target.vectors[1][0]*target.vectors[2][2],
+                     target.vectors[1][0]*target.vectors[2][1]-target.vectors[1][1]*target.vectors[2][0]};
+    double volume=fabs(dot(target.vectors[0],cross));
+    if(volume==0.0 || scale==0.0)
+    {
+        target.error="lattice vectors don't give a lattice";
+        return(false);
+    }
+    //a negative scale is the volume of the cell.
+    if(scale<0.0)
+    {
+        scale=cbrt(-scale/volume);
+    }
+    for(int i=0;i<3;i++)
+    {
+        for(int j=0;j<3;j++)
+        {
+            target.vectors[i][j]*=scale;
+            target.tomiller[i][j] = i==j ? 1.0 : 0.0;
+        }
+    }
+    return(true);
+}
+
+void latticeimport::readfile(const std::string &name, lattice &target)
+{
+    target.valid=false;
+    int fd=open(name.c_str(),O_RDONLY);
+    if(fd<0)
+    {
+        target.error="cannot open";
+        return;
+    }
+    struct stat info;
+    if(fstat(fd,&info)!=0 || info.st_size==0)
+    {
+        close(fd);
+        target.error="empty";
+        return;
+    }
+    void *mapped=mmap(0,info.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+    close(fd);
+    if(mapped==MAP_FAILED)
+    {
+        target.error="cannot map";
+        return;
+    }
+    const char *data=static_cast<const char*>(mapped);
+    bool cif = name.size()>=4 && strcasecmp(name.c_str()+name.size()-4,".cif")==0;
+    target.valid = cif ? readcif(data,info.st_size,target) : readposcar(data,info.st_size,target);
+    munmap(mapped,info.st_size);
+}
+
+bool latticeimport::surface(const lattice &source, const int miller[3], double &a, double &b, double &angle)
+{
+    //the indices for the primitive cell. Centering gives halves and thirds, those go away with the common divisor.
+    long h[3];
+    for(int i=0;i<3;i++)
+    {
+        double index=0.0;
+        for(int j=0;j<3;j++)
+        {
+            index+=source.tomiller[i][j]*miller[j];
+        }
+        h[i]=lround(6.0*index);
+    }
+    long p, q;
+    long divisor=extendedgcd(extendedgcd(h[0],h[1],p,q),h[2],p,q);
+    if(divisor==0)
+    {
+        return(false);
+    }
+    for(int i=0;i<3;i++)
+    {
+        h[i]/=divisor;
+    }
+    //a basis of the integer solutions of h.n=0: u in the plane z=0, v takes the smallest possible step in z.
+    long u[3], v[3];
+    long g=extendedgcd(h[0],h[1],p,q);
+    if(g==0)
+    {
+        u[0]=1; u[1]=0; u[2]=0;
+        v[0]=0; v[1]=1; v[2]=0;
+    }
+    else
+    {
+        u[0]=h[1]/g; u[1]=-h[0]/g; u[2]=0;
+        v[0]=-h[2]*p; v[1]=-h[2]*q; v[2]=g;
+    }
+    double first[3], second[3];
+    for(int j=0;j<3;j++)
+    {
+        first[j]=u[0]*source.vectors[0][j]+u[1]*source.vectors[1][j]+u[2]*source.vectors[2][j];
+        second[j]=v[0]*source.vectors[0][j]+v[1]*source.vectors[1][j]+v[2]*source.vectors[2][j];
+    }
+    //Gauss reduction: afterwards first is the shortest vector, and second the shortest one not parallel to it.
+    for(;;)
+    {
+        if(dot(second,second)<dot(first,first))
+        {
+            std::swap(first,second);
+        }
+        double m=round(dot(first,second)/dot(first,first));
+        if(m==0.0)
+        {
+            break;
+        }
+        for(int j=0;j<3;j++)
+        {
+            second[j]-=m*first[j];
+        }
+    }
+    a=sqrt(dot(first,first));
+    b=sqrt(dot(second,second));
+    angle=acos(fmax(-1.0,fmin(1.0,dot(first,second)/(a*b))))*180.0/M_PI;
+    //the obtuse one of the two choices. matchsolver only recognizes hexagonal cells by the exact angle.
+    if(angle<90.0)
+    {
+        angle=180.0-angle;
+    }
+    if(fabs(angle-120.0)<1e-6)
+    {
+        angle=120.0;
+    }
+    else if(fabs(angle-90.0)<1e-6)
+    {
+        angle=90.0;
+    }
+    return(true);
+}
+
+bool latticeimport::readlist(FILE *input)
+{
+    char line[2048], names[2][1024];
+    int miller[2][3];
+    unsigned int linenumber=0;
+    bool ok=true;
+    while(fgets(line,sizeof(line),input))
+    {
+        linenumber++;
+        const char *start=line+strspn(line," \t\r\n");
+        if(*start=='\0' || *start=='#')
+        {
+            continue;
+        }
+        if(sscanf(start,"%1023s %d %d %d %1023s %d %d %d",names[0],&miller[0][0],&miller[0][1],&miller[0][2],names[1],&miller[1][0],&miller[1][1],&miller[1][2])!=8)
+        {
+            std::cerr << "Import line " << linenumber << " is not: substratefile h k l adlayerfile h k l, skipping it." << std::endl;
+            ok=false;
+            continue;
+        }
+        job entry;
+        entry.line=linenumber;
+        for(int side=0;side<2;side++)
+        {
+            std::map<std::string,size_t>::iterator known=fileindices.find(names[side]);
+            if(known==fileindices.end())
+            {
+                known=fileindices.insert(std::make_pair(std::string(names[side]),files.size())).first;
+                files.push_back(names[side]);
+            }
+            entry.file[side]=known->second;
+            std::copy(miller[side],miller[side]+3,entry.miller[side]);
+        }
+        jobs.push_back(entry);
+    }
+    return(ok);
+}
+
+void latticeimport::readfiles()
+{
+    lattices.resize(files.size());
+    unsigned int threads=std::thread::hardware_concurrency();
+    if(threads==0)
+    {
+        threads=1;
+    }
+    if(threads>files.size())
+    {
+        threads=files.size();
+    }
+    //the files differ a lot in size, so the threads take the next one whenever they are done, instead of fixed shares.
+    std::atomic<size_t> next(0);
+    auto worker=[&]()
+    {
+        for(size_t i=next++;i<files.size();i=next++)
+        {
+            readfile(files[i],lattices[i]);
+        }
+    };
+    std::vector<std::thread> pool;
+    for(unsigned int t=1;t<threads;t++)
+    {
+        pool.push_back(std::thread(worker));
+    }
+    worker();
+    for(size_t t=0;t<pool.size();t++)
+    {
+        pool[t].join();
+    }
+}
+
+size_t latticeimport::size() const
+{
+    return(jobs.size());
+}
+
+bool latticeimport::getparams(size_t k, double lengthtolerance, double angletolerance, double commargs[9]) const
+{
+    const job &entry=jobs[k];
+    double cell[2][3];
+    for(int side=0;side<2;side++)
+    {
+        const lattice &source=lattices[entry.file[side]];
+        if(!source.valid)
+        {
+            std::cerr << "Import line " << entry.line << ": " << files[entry.file[side]] << ": " << source.error << ", skipping it." << std::endl;
+            return(false);
+        }
+        if(!surface(source,entry.miller[side],cell[side][0],cell[side][1],cell[side][2]))
+        {
+            std::cerr << "Import line " << entry.line << ": Miller indices 0 0 0 for " << files[entry.file[side]] << ", skipping it." << std::endl;
+            return(false);
+        }
+    }
+    double relative=fabs(lengthtolerance)/100.0;
+    commargs[0]=cell[0][0];
+    commargs[1]=cell[0][1];
+    commargs[2]=cell[0][2];
+    commargs[3]=cell[1][0]*(1.0-relative);
+    commargs[4]=cell[1][0]*(1.0+relative);
+    commargs[5]=cell[1][1]*(1.0-relative);
+    commargs[6]=cell[1][1]*(1.0+relative);
+    commargs[7]=cell[1][2]-fabs(angletolerance);
+    commargs[8]=cell[1][2]+fabs(angletolerance);
+    return(true);
+}
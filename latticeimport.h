@@ -0,0 +1,86 @@
+/*
+ * LatticeMatch calculator - importing lattices from crystallographic files
+ * Copyright (C) 2015 Andreas Grois
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ *
+ * Turns a list of substrate/adlayer pairs of CIF or POSCAR files into the nine numbers of a batch entry.
+ * Each line of the list reads
+ *   substratefile h k l adlayerfile h k l
+ * with the Miller indices of the surface plane of each. The 2D cell of a plane is made of the two shortest
+ * lattice vectors in it (Gauss reduced, angle between 90 and 120 degrees). The substrate cell is used as it is,
+ * the adlayer cell gets a relative tolerance on the lengths and an absolute one on the angle.
+ *
+ * The files are memory mapped, and every file is read only once, on as many threads as there are cores, even
+ * if it appears in many lines. Files ending in .cif are read as CIF (the first data block, cell parameters
+ * and the centering letter of the space group symbol, so Miller indices refer to the conventional cell),
+ * everything else as POSCAR (the cell as given, taken to be primitive).
+ *
+ * This class is part of the LatticeMatch program.
+ *
+ * To contact the author either use electronic mail: Andreas Grois <andreas.grois@jku.at>
+ * or write to:
+ * Andreas Grois, Institute for Semiconductor and SolidState physics, Johannes Kepler University,
+ * Altenbergerstraße 69, 4040 Linz, AUSTRIA
+ */
+
+#ifndef LATTICEIMPORT_H
+#define LATTICEIMPORT_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <map>
+
+class latticeimport
+{
+private:
+    //a 3D lattice: primitive vectors in cartesian coordinates, and how to get from the Miller indices of the file
+    //to those of the primitive cell.
+    struct lattice
+    {
+        bool valid;
+        std::string error;
+        double vectors[3][3];
+        double tomiller[3][3]; //primitive index i = sum over j of tomiller[i][j]*file index j
+    };
+    struct job
+    {
+        unsigned int line;
+        size_t file[2]; //substrate, adlayer
+        int miller[2][3];
+    };
+    std::vector<std::string> files;
+    std::map<std::string,size_t> fileindices;
+    std::vector<lattice> lattices;
+    std::vector<job> jobs;
+
+    static void readfile(const std::string &name, lattice &target);
+    static bool readcif(const char *data, size_t length, lattice &target);
+    static bool readposcar(const char *data, size_t length, lattice &target);
+    static bool surface(const lattice &source, const int miller[3], double &a, double &b, double &angle);
+public:
+    //reads the list. Lines that don't parse are reported to cerr and skipped, false if there were any.
+    bool readlist(FILE *input);
+    //reads all files named in the list, in parallel.
+    void readfiles();
+    size_t size() const;
+    //the nine numbers of entry k, angles in degrees, ready for sanitize(). Tolerances in percent and degrees.
+    //false (and a message to cerr) if one of the files could not be read, or the plane makes no sense.
+    bool getparams(size_t k, double lengthtolerance, double angletolerance, double commargs[9]) const;
+};
+
+#endif // LATTICEIMPORT_H
@@ -0,0 +1,203 @@
+/*
+ * LatticeMatch calculator - plain C interface of the library
+ * Copyright (C) 2015 Andreas Grois
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ *
+ * See latticematch.h. Every entry point catches everything, the C side can't do anything with an exception.
+ *
+ * This file is part of the LatticeMatch program.
+ *
+ * To contact the author either use electronic mail: Andreas Grois <andreas.grois@jku.at>
+ * or write to:
+ * Andreas Grois, Institute for Semiconductor and SolidState physics, Johannes Kepler University,
+ * Altenbergerstraße 69, 4040 Linz, AUSTRIA
+ */
+
+#include "latticematch.h"
+#include "matchsolver.h"
+#include <cmath>
+#include <climits>
+#include <new>
+
+struct lm_solver
+{
+    matchsolver solver;
+    bool solved;
+};
+
+//the number of ranges set has, as written by copyout.
+static size_t rangecount(angleset &set)
+{
+    return(set.iscircle() ? 1 : set.getrangesref().size());
+}
+
+static void copyout(angleset &set, double *target)
+{
+    if(set.iscircle())
+    {
+        target[0]=0.0;
+        target[1]=360.0;
+        return;
+    }
+    const std::vector<anglerange> &storage=set.getrangesref();
+    for(std::vector<anglerange>::const_iterator i=storage.begin();i!=storage.end();++i)
+    {
+        //the same conversion as the text output, so the numbers agree.
+        *target++=i->getlower().getval()*180/M_PI;
+        *target++=i->getupper().getval()*180/M_PI;
+    }
+}
+
+lm_solver *lm_create(void)
+{
+    try
+    {
+        lm_solver *solver=new lm_solver;
+        solver->solved=false;
+        return(solver);
+    }
+    catch(...)
+    {
+        return(0);
+    }
+}
+
+void lm_destroy(lm_solver *solver)
+{
+    delete solver;
+}
+
+int lm_set_min_width(lm_solver *solver, double degrees)
+{
+    if(!solver || !std::isfinite(degrees))
+    {
+        return(LM_INVALID_ARGUMENT);
+    }
+    solver->solver.setminwidth(fabs(degrees)*M_PI/180.0);
+    return(LM_OK);
+}
+
+int lm_set_strain(lm_solver *solver, double relative)
+{
+    if(!solver || !(relative>=0.0 && relative<1.0))
+    {
+        return(LM_INVALID_ARGUMENT);
+    }
+    solver->solver.setstrain(relative);
+    return(LM_OK);
+}
+
+int lm_set_max_determinant(lm_solver *solver, unsigned int cells)
+{
+    if(!solver)
+    {
+        return(LM_INVALID_ARGUMENT);
+    }
+    solver->solver.setmaxdeterminant(cells);
+    return(LM_OK);
+}
+
+int lm_set_asin_table(lm_solver *solver, int use)
+{
+    if(!solver)
+    {
+        return(LM_INVALID_ARGUMENT);
+    }
+    try
+    {
+        //the shared table is built on first use, that's the one thing here that can throw.
+        solver->solver.setasintable(use ? &asintable::shared() : 0);
+    }
+    catch(...)
+    {
+        return(LM_INTERNAL_ERROR);
+    }
+    return(LM_OK);
+}
+
+int lm_solve(lm_solver *solver, const double params[9], double *coincident, size_t *coincidentcount, double *commensurate, size_t *commensuratecount)
+{
+    if(!solver || !params)
+    {
+        return(LM_INVALID_ARGUMENT);
+    }
+    solver->solved=false;
+    double input[9];
+    for(int i=0;i<9;i++)
+    {
+        if(!std::isfinite(params[i]))
+        {
+            return(LM_INVALID_ARGUMENT);
+        }
+        input[i]=params[i];
+    }
+    matchsolver::sanitize(input);
+    //zero lengths would make the index limits infinite, and so would alpha at 0 or 180 degrees. Limits that are
+    //merely huge don't fit into an unsigned int either, so they are checked the way setlimits() computes them,
+    //with room for a strain below 1 and for the four ranges per index the families reserve.
+    if(input[matchsolver::A1]==0.0 || input[matchsolver::A2]==0.0 || input[matchsolver::B1MAX]==0.0 || input[matchsolver::B2MAX]==0.0)
+    {
+        return(LM_INVALID_ARGUMENT);
+    }
+    const double longest=2.0*fmax(input[matchsolver::B1MAX],input[matchsolver::B2MAX]);
+    const double shortest=fmin(input[matchsolver::A1],input[matchsolver::A2])*fabs(sin(input[matchsolver::ALPHA]));
+    if(!(longest/shortest<UINT_MAX/8))
+    {
+        return(LM_INVALID_ARGUMENT);
+    }
+    try
+    {
+        solver->solver.setparams(input);
+        solver->solver.solve();
+    }
+    catch(...)
+    {
+        return(LM_INTERNAL_ERROR);
+    }
+    solver->solved=true;
+    return(lm_results(solver,coincident,coincidentcount,commensurate,commensuratecount));
+}
+
+int lm_results(lm_solver *solver, double *coincident, size_t *coincidentcount, double *commensurate, size_t *commensuratecount)
+{
+    if(!solver || !coincidentcount || !commensuratecount)
+    {
+        return(LM_INVALID_ARGUMENT);
+    }
+    if(!solver->solved)
+    {
+        return(LM_NOT_SOLVED);
+    }
+    angleset &coincidentset=solver->solver.getcoincident();
+    angleset &commensurateset=solver->solver.getcommensurate();
+    size_t coincidentneeded=rangecount(coincidentset);
+    size_t commensurateneeded=rangecount(commensurateset);
+    bool fits=(coincidentneeded<=*coincidentcount && commensurateneeded<=*commensuratecount);
+    *coincidentcount=coincidentneeded;
+    *commensuratecount=commensurateneeded;
+    if(!fits)
+    {
+        return(LM_BUFFER_TOO_SMALL);
+    }
+    if((coincidentneeded>0 && !coincident) || (commensurateneeded>0 && !commensurate))
+    {
+        return(LM_INVALID_ARGUMENT);
+    }
+    copyout(coincidentset,coincident);
+    copyout(commensurateset,commensurate);
+    return(LM_OK);
+}
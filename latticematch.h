@@ -0,0 +1,92 @@
+/*
+ * LatticeMatch calculator - plain C interface of the library
+ * Copyright (C) 2015 Andreas Grois
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ *
+ * For programs that call the solver many times, e.g. from inside a growth simulation, and are not written in
+ * C++. Everything goes through an opaque handle, which keeps the solver and its working memory between calls.
+ * The results are written into arrays the caller owns: the library never hands out memory that has to be
+ * freed, and the working sets of the solver stay in the handle from one call to the next: the families, their
+ * overlaps and the results are filled in place. Only a handle that meets a problem larger than any it has
+ * solved before grows them; from then on lm_solve() and lm_results() don't allocate. No C++ exception gets
+ * out, every function returns one of the lm_status values instead.
+ *
+ * The parameters are the nine numbers of the command line, in the same order and units:
+ *   a1 a2 alpha b1min b1max b2min b2max betamin betamax, angles in degrees.
+ * They are sanitized just like there, without the warnings.
+ * A range is written as two doubles, lower and upper border, in degrees, in [0:360). A range going through
+ * 0 has upper<lower. A full circle is the one range 0 360. The ranges come sorted, like in the text output.
+ *
+ * A handle must not be used by two threads at once, but any number of handles can be used in parallel.
+ * From Fortran, bind(C) interfaces with c_ptr, c_double and c_size_t match these declarations.
+ *
+ * This file is part of the LatticeMatch program.
+ *
+ * To contact the author either use electronic mail: Andreas Grois <andreas.grois@jku.at>
+ * or write to:
+ * Andreas Grois, Institute for Semiconductor and SolidState physics, Johannes Kepler University,
+ * Altenbergerstraße 69, 4040 Linz, AUSTRIA
+ */
+
+#ifndef LATTICEMATCH_H
+#define LATTICEMATCH_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum lm_status
+{
+    LM_OK=0,
+    LM_BUFFER_TOO_SMALL=1,      /* the counts say how many ranges there are, nothing was written */
+    LM_INVALID_ARGUMENT=-1,     /* null pointer, or parameters that aren't finite, give zero lengths, an alpha
+                                   of 0 or 180 degrees, or indices beyond what an unsigned int can count */
+    LM_NOT_SOLVED=-2,           /* lm_results() before a successful lm_solve() */
+    LM_INTERNAL_ERROR=-3        /* out of memory, or anything else that went wrong inside */
+};
+
+typedef struct lm_solver lm_solver;
+
+/* a new handle, 0 if there is not enough memory. */
+lm_solver *lm_create(void);
+/* frees the handle. 0 is fine. */
+void lm_destroy(lm_solver *solver);
+
+/* see --min-width. Takes effect with the next lm_solve(). */
+int lm_set_min_width(lm_solver *solver, double degrees);
+/* see --strain, relative (0.01 for 1%), in [0:1). Takes effect with the next lm_solve(). */
+int lm_set_strain(lm_solver *solver, double relative);
+/* see --max-det, 0 for no limit. Takes effect with the next lm_solve(). */
+int lm_set_max_determinant(lm_solver *solver, unsigned int cells);
+/* see --asin-table. 0: evaluate asin directly (the default), anything else: use the table. */
+int lm_set_asin_table(lm_solver *solver, int use);
+
+/* Solves for the nine parameters. On input *coincidentcount and *commensuratecount are the number of ranges
+ * the arrays have room for (each range takes two doubles), on output the number of ranges there are.
+ * If one of the arrays is too small, LM_BUFFER_TOO_SMALL is returned and neither array is written, but the
+ * results are kept: lm_results() hands them out without solving again, once there is room. */
+int lm_solve(lm_solver *solver, const double params[9], double *coincident, size_t *coincidentcount, double *commensurate, size_t *commensuratecount);
+/* the results of the last lm_solve() again, with the same rules for the counts. */
+int lm_results(lm_solver *solver, double *coincident, size_t *coincidentcount, double *commensurate, size_t *commensuratecount);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LATTICEMATCH_H */
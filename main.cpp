@@ -67,358 +67,1233 @@
 #include <vector>
 #include <cmath>
 #include <cstdio>
+#include <cstring>
+#include <cstdlib>
 #include <algorithm>
+#include <memory>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <atomic>
+#include <fcntl.h>
 #include "angleset.h"
+#include "matchsolver.h"
+#include "outbuffer.h"
+#include "textwriter.h"
+#include "binarywriter.h"
+#include "jsonwriter.h"
+#include "archivewriter.h"
+#include "archivereader.h"
+#include "shmwriter.h"
+#include "rangescore.h"
+#include "latticeimport.h"
+#include "rangeiterator.h"
+#include "reorderbuffer.h"
+#include "thetascan.h"
 
 using namespace std;
 
 enum commargnames{A1,A2,ALPHA,B1MIN,B1MAX,B2MIN,B2MAX,BETAMIN,BETAMAX};
 
-int main(int argc, char* argv[])
+//Never trust the user. The numbers are put in order by matchsolver::sanitize(), this tells what it had to fix.
+static void sanitize(double commargs[9])
 {
-    //This is largely a copy of what I already did in plain C.
-    //There will be a lot of plain C code here, so don't look too close...
-    if(argc!=10)
+    unsigned int fixed=matchsolver::sanitize(commargs);
+    if(fixed&matchsolver::SANITIZED_B_SIGNS)
     {
-        cout << "Usage: " << argv[0] << " a1 a2 alpha b1min b1max b2min b2max betamin betamax" << std::endl << "Please input angles in degrees." << std::endl;
-        return(-1);
+        std::cerr << "Warning: negative values for b1, b2 don't make any sense. Putting them back in order." << std::endl;
+    }
+    if(fixed&matchsolver::SANITIZED_A_SIGNS)
+    {
+        std::cerr << "Warning: negative values for a1, a2 don't make any sense. Putting them back in order." << std::endl;
+    }
+    if(fixed&matchsolver::SANITIZED_WIDE_BETA)
+    {
+        std::cerr << "Warning: Sanitized betamax and betamin are more than 180 degrees apart.\n\tThat's probably not what you intended. betamax: " << commargs[BETAMAX]*180.0/M_PI << ", betamin: " << commargs[BETAMIN]*180.0/M_PI << "\n\tAre you trying to use put a beta range including zero? Edit the source code for that..." << std::endl;
+    }
+}
+
+//what is done for each set of input numbers, be it from the command line, or from a batch file.
+struct runoptions
+{
+    std::vector<double> extensions; //pairs of b1max, b2max
+    double sweepstep;
+    unsigned int sweepcount;
+    matchsink *stream; //0 unless the results are streamed while solving
+    unsigned int streamsectors;
+    double anytime; //time budget in seconds for anytime solving, 0 if off
+    enum {QUERY_NONE,QUERY_EXISTS,QUERY_COUNT} query;
+    unsigned int top; //only keep this many ranges per set, 0 for all of them
+    enum {RANK_WIDTH,RANK_MISFIT} rank; //how top picks them, see rangescore.h
+    unsigned int first; //only this many ranges, starting at from (radians), 0 for all of them
+    double from;
+    //enumerate: commensurate matches only, by enumerating the matrices, see matchsolver::solveenumerated().
+    //scan: on a grid of scanpoints, see matchsolver::solvescan().
+    enum {ENGINE_RANGES,ENGINE_ENUMERATE,ENGINE_SCAN} engine;
+    unsigned int scanpoints;
+};
+
+//what a solve gives, apart from what is kept in the solver
+struct solveanswer
+{
+    bool exists;
+    unsigned long count;
+};
+
+//the solving half of solveandwrite(), for everything that doesn't need the writer while solving.
+static void solveonly(matchsolver &solver, const runoptions &options, solveanswer &answer)
+{
+    if(options.query==runoptions::QUERY_EXISTS)
+    {
+        answer.exists=solver.findcommensurate();
+    }
+    else if(options.query==runoptions::QUERY_COUNT)
+    {
+        answer.count=solver.countcommensurate();
+    }
+    else if(options.top>0)
+    {
+        if(options.rank==runoptions::RANK_MISFIT)
+        {
+            //the misfit depends on the parameters, so every job gets its own.
+            double params[9];
+            for(int i=0;i<9;i++)
+            {
+                params[i]=solver.getparam(static_cast<matchsolver::paramnames>(i));
+            }
+            solver.solvetop(options.top,misfitscore(params,solver.getloops()));
+        }
+        else
+        {
+            solver.solvetop(options.top,widthscore());
+        }
+    }
+    else if(options.engine==runoptions::ENGINE_ENUMERATE)
+    {
+        solver.solveenumerated();
+    }
+    else if(options.engine==runoptions::ENGINE_SCAN)
+    {
+        solver.solvescan(options.scanpoints);
+    }
+    else
+    {
+        solver.solve();
+    }
+}
+
+//and the writing half
+static void writeanswer(matchsolver &solver, resultwriter &writer, const runoptions &options, const solveanswer &answer)
+{
+    if(options.query==runoptions::QUERY_EXISTS)
+    {
+        writer.writeexists(solver,answer.exists);
+    }
+    else if(options.query==runoptions::QUERY_COUNT)
+    {
+        writer.writecount(solver,answer.count);
     }
     else
     {
-        //read in command line arguments
-        double commargs[9], swapper;
-        unsigned int i;
-        for(i=1;i<(unsigned)argc;i++)
+        writer.writeresults(solver);
+    }
+}
+
+//solves, and hands the results to the writer, either at the end or while solving
+static void solveandwrite(matchsolver &solver, resultwriter &writer, const runoptions &options)
+{
+    if(options.first>0)
+    {
+        //only as much of the circle is solved as it takes to find them.
+        rangeiterator ranges(solver,options.from,options.streamsectors);
+        rangeiterator::match found;
+        for(unsigned int n=0;n<options.first && ranges.next(found);n++)
         {
-            //what is this stringstreams stuff everyone is hyped about?!?
-           sscanf(argv[i],"%lf",&(commargs[i-1]));
+            options.stream->writefinalrange(found.commensurate,found.range);
+        }
+        options.stream->writesectordone();
+    }
+    else if(options.stream)
+    {
+        solver.solve(options.streamsectors,*options.stream);
+    }
+    else
+    {
+        solveanswer answer;
+        solveonly(solver,options,answer);
+        writeanswer(solver,writer,options,answer);
+    }
+}
+
+//anytime solving: indices up to 4, 8, 16, ... until the results are complete, or the time is up.
+static int runshells(matchsolver &solver, resultwriter &writer, double budget)
+{
+    std::chrono::steady_clock::time_point start=std::chrono::steady_clock::now();
+    for(unsigned int maxindex=4;;maxindex*=2)
+    {
+        solver.refine(maxindex);
+        bool complete=solver.iscomplete();
+        writer.writeshell(maxindex,complete);
+        writer.writeresults(solver);
+        //someone is waiting for this.
+        writer.flush();
+        if(complete)
+        {
+            return(0);
+        }
+        //twice the indices give twice the ranges, and overlapping them is quadratic. Don't start a shell that won't finish.
+        double elapsed=std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+        if(elapsed+4.0*solver.getsolvetime()>budget)
+        {
+            cerr << "Time budget used up, the results are complete up to index " << maxindex << " only." << std::endl;
+            return(0);
+        }
+    }
+}
+
+static int runjob(const double commargs[9], matchsolver &solver, resultwriter &writer, const runoptions &options)
+{
+    if(options.sweepcount>0)
+    {
+        //one solver for all points, so the storage gets reused.
+        double point[9];
+        for(unsigned int k=0;k<options.sweepcount;k++)
+        {
+            std::copy(commargs,commargs+9,point);
+            point[B1MIN]=commargs[B1MIN]+k*options.sweepstep;
+            point[B1MAX]=commargs[B1MAX]+k*options.sweepstep;
+            if(point[B1MIN]<=0.0)
+            {
+                cerr << "Sweep point " << k << " has a non-positive b1min, stopping." << std::endl;
+                return(-1);
+            }
+            solver.setparams(point);
+            writer.writesweeppoint(k,point[B1MIN],point[B1MAX]);
+            solveandwrite(solver,writer,options);
+        }
+        return(0);
+    }
+    solver.setparams(commargs);
+    if(options.anytime>0.0)
+    {
+        return(runshells(solver,writer,options.anytime));
+    }
+    solveandwrite(solver,writer,options);
+
+    for(size_t ext=0;ext<options.extensions.size();ext+=2)
+    {
+        //extensions must not shrink the window. Using the larger value of old and new keeps the solver happy.
+        double b1max=fmax(options.extensions[ext],solver.getparam(matchsolver::B1MAX));
+        double b2max=fmax(options.extensions[ext+1],solver.getparam(matchsolver::B2MAX));
+        writer.writeextension(b1max,b2max);
+        solver.extend(b1max,b2max);
+        writer.writeresults(solver);
+    }
+    return(0);
+}
+
+//the time one call of solve takes, in seconds. Repeated until it took a tenth of a second in all, so even
+//the fast cases get a sensible number.
+template<class solving> static double timeit(solving solve)
+{
+    unsigned int runs=0;
+    double elapsed;
+    std::chrono::steady_clock::time_point start=std::chrono::steady_clock::now();
+    do
+    {
+        solve();
+        runs++;
+        elapsed=std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+    } while(elapsed<0.1);
+    return(elapsed/runs);
+}
+
+//true if angle is inside one of ranges, which are consolidated and sorted. hit gets the index of that range.
+static bool insideranges(const std::vector<anglerange> &ranges, double angle, size_t &hit)
+{
+    //sorted by lower border, so only the last one starting before angle can hold it, or the last one of all,
+    //if it goes through 0.
+    size_t k=std::upper_bound(ranges.begin(),ranges.end(),angle,[](double value, const anglerange &range){ return(value<range.getlower().getval()); })-ranges.begin();
+    if(k>0 && ranges[k-1].isinside(angle))
+    {
+        hit=k-1;
+        return(true);
+    }
+    if(!ranges.empty() && ranges.back().isinside(angle))
+    {
+        hit=ranges.size()-1;
+        return(true);
+    }
+    return(false);
+}
+
+//an angle that disagrees with the ranges this close to one of their borders is rounding: the asin table alone
+//moves borders by up to 1e-9, and some ranges are single points.
+static const double bordermargin=1e-8;
+
+//how far angle is from the nearest border of ranges, radians, whichever way round the circle is shorter.
+static double borderdistance(const std::vector<anglerange> &ranges, double angle)
+{
+    double nearest=2*M_PI;
+    for(std::vector<anglerange>::const_iterator i=ranges.begin();i!=ranges.end();++i)
+    {
+        const double borders[2]={i->getlower().getval(),i->getupper().getval()};
+        for(int b=0;b<2;b++)
+        {
+            double distance=fabs(angle-borders[b]);
+            nearest=fmin(nearest,fmin(distance,2*M_PI-distance));
+        }
+    }
+    return(nearest);
+}
+
+//compares one set of the ranges with the scan, grid point by grid point. Returns how many points disagree,
+//far gets those of them that aren't within bordermargin of a border.
+static size_t scandisagreement(angleset &ranges, const std::vector<unsigned char> &flags, unsigned char flag, size_t &far)
+{
+    const bool circle=ranges.iscircle();
+    const std::vector<anglerange> &storage=ranges.getrangesref();
+    size_t differ=0;
+    far=0;
+    for(size_t k=0;k<flags.size();k++)
+    {
+        const double angle=2*M_PI*k/flags.size();
+        size_t hit;
+        if((circle || insideranges(storage,angle,hit))!=((flags[k]&flag)!=0))
+        {
+            differ++;
+            if(circle || borderdistance(storage,angle)>bordermargin)
+            {
+                far++;
+            }
+        }
+    }
+    return(differ);
+}
+
+//true if both sets have exactly the same ranges, borders and all, as they would be written. Both have to be sorted.
+static bool sameranges(angleset &a, angleset &b)
+{
+    const std::vector<anglerange> &first=a.getrangesref(), &second=b.getrangesref();
+    if(first.size()!=second.size())
+    {
+        return(false);
+    }
+    for(size_t k=0;k<first.size();k++)
+    {
+        if(first[k].iscircle()!=second[k].iscircle() || first[k].getlower().getval()!=second[k].getlower().getval()
+           || first[k].getupper().getval()!=second[k].getupper().getval())
+        {
+            return(false);
+        }
+    }
+    return(true);
+}
+
+//--benchmark: the three ways of finding matches, how long they take, and whether they agree.
+//Every exact match has to be inside the ranges, the other way round it doesn't hold: the ranges are wider.
+//The scan has to agree with the ranges on every grid point, except right at their borders.
+static int runbenchmark(const double commargs[9], matchsolver &solver, unsigned int entry, unsigned int scanpoints)
+{
+    int retval=0;
+    solver.setparams(commargs);
+    double rangetime=timeit([&]{ solver.solve(); });
+    angleset coincident=solver.getcoincident();
+    angleset ranges=solver.getcommensurate();
+    unsigned long matrices=0;
+    double enumeratetime=timeit([&]{ matrices=solver.solveenumerated(); });
+    const std::vector<anglerange> &points=solver.getcommensurate().getrangesref();
+    const std::vector<anglerange> &storage=ranges.getrangesref();
+    bool circle=ranges.iscircle();
+    std::vector<bool> used(storage.size(),false);
+    size_t outside=0;
+    for(std::vector<anglerange>::const_iterator i=points.begin();i!=points.end();++i)
+    {
+        size_t hit;
+        if(circle)
+        {
+            continue;
+        }
+        if(insideranges(storage,i->getlower().getval(),hit))
+        {
+            used[hit]=true;
+        }
+        else if(borderdistance(storage,i->getlower().getval())>bordermargin)
+        {
+            outside++;
+        }
+    }
+    //the shells of --anytime, once they are complete, have to be what solve() gives.
+    matchsolver shells(solver);
+    double shelltime=timeit([&]
+    {
+        shells.setparams(commargs);
+        unsigned int maxindex=4;
+        do
+        {
+            shells.refine(maxindex);
+            maxindex*=2;
+        } while(!shells.iscomplete());
+    });
+    const bool shellsagree=sameranges(shells.getcoincident(),coincident) && sameranges(shells.getcommensurate(),ranges);
+    double input[9];
+    for(int i=0;i<9;i++)
+    {
+        input[i]=solver.getparam(static_cast<matchsolver::paramnames>(i));
+    }
+    thetascan scanner(input,solver.getloops());
+    std::vector<unsigned char> flags;
+    double scantime=timeit([&]{ scanner.scan(scanpoints,flags); });
+    size_t coincidentfar, commensuratefar;
+    size_t coincidentdiffer=scandisagreement(coincident,flags,thetascan::SCAN_COINCIDENT,coincidentfar);
+    size_t commensuratediffer=scandisagreement(ranges,flags,thetascan::SCAN_COMMENSURATE,commensuratefar);
+    cout << "Benchmark entry " << entry << ":" << std::endl;
+    cout << "  ranges:      " << rangetime << " s, " << (circle ? 1 : storage.size()) << " commensurate ranges" << std::endl;
+    cout << "  enumeration: " << enumeratetime << " s, " << matrices << " matrices at " << points.size() << " angles, "
+         << rangetime/enumeratetime << " times as fast" << std::endl;
+    cout << "  scan:        " << scantime << " s, " << scanpoints << " grid points, " << rangetime/scantime << " times as fast" << std::endl;
+    cout << "  anytime:     " << shelltime << " s, " << (shellsagree ? "the complete shells are the same as the ranges" : "disagreement: the complete shells differ from the ranges") << std::endl;
+    if(!shellsagree)
+    {
+        retval=-1;
+    }
+    if(outside>0)
+    {
+        cout << "  disagreement: " << outside << " of " << points.size() << " angles outside the ranges" << std::endl;
+        retval=-1;
+    }
+    else
+    {
+        cout << "  agreement: all angles inside the ranges, ";
+        if(circle)
+        {
+            cout << "which cover the full circle" << std::endl;
+        }
+        else
+        {
+            cout << std::count(used.begin(),used.end(),false) << " ranges without an exact match" << std::endl;
+        }
+    }
+    if(coincidentfar>0 || commensuratefar>0)
+    {
+        cout << "  scan disagreement: " << coincidentfar << " coincident and " << commensuratefar
+             << " commensurate grid points away from the borders of the ranges" << std::endl;
+        retval=-1;
+    }
+    else
+    {
+        cout << "  scan agreement: " << coincidentdiffer << " coincident and " << commensuratediffer
+             << " commensurate grid points differ, all at borders of the ranges" << std::endl;
+    }
+    return(retval);
+}
+
+//what is done with each entry of a batch: solved right away, or queued for the threads. Gets sanitized numbers.
+typedef std::function<int(const double commargs[9])> entryhandler;
+
+//reads one set of nine numbers per line. Empty lines and lines starting with # are skipped.
+static int runbatch(FILE *input, const entryhandler &handler)
+{
+    char line[1024];
+    unsigned int linenumber=0;
+    int retval=0;
+    while(fgets(line,sizeof(line),input))
+    {
+        linenumber++;
+        const char *start=line+strspn(line," \t\r\n");
+        if(*start=='\0' || *start=='#')
+        {
+            continue;
+        }
+        double commargs[9];
+        if(sscanf(start,"%lf %lf %lf %lf %lf %lf %lf %lf %lf",&commargs[0],&commargs[1],&commargs[2],&commargs[3],&commargs[4],&commargs[5],&commargs[6],&commargs[7],&commargs[8])!=9)
+        {
+            cerr << "Batch line " << linenumber << " does not contain nine numbers, skipping it." << std::endl;
+            retval=-1;
+            continue;
         }
-        //Never trust the user. I know that I'll probably be the only one to use this program, but that's just another reason...
-        //to make sure that the minimum values are actually smaller than the maximum numbers. Also, we need radians, not degrees.
-        if(commargs[B1MIN]*commargs[B2MIN]<0 || commargs[B1MAX]*commargs[B2MAX]<0 || commargs[B1MIN]*commargs[B1MAX]<0)
+        sanitize(commargs);
+        if(handler(commargs)!=0)
         {
-            std::cerr << "Warning: negative values for b1, b2 don't make any sense. Putting them back in order." << std::endl;
-            commargs[BETAMIN]=180-commargs[BETAMIN];
-            commargs[BETAMAX]=180-commargs[BETAMAX];
+            retval=-1;
         }
-        if(commargs[A1]*commargs[A2]<0)
+    }
+    return(retval);
+}
+
+//the same for an import list: the nine numbers come from crystallographic files, see latticeimport.h.
+static int runimport(FILE *input, double lengthtolerance, double angletolerance, const entryhandler &handler)
+{
+    latticeimport import;
+    int retval = import.readlist(input) ? 0 : -1;
+    import.readfiles();
+    for(size_t k=0;k<import.size();k++)
+    {
+        double commargs[9];
+        if(!import.getparams(k,lengthtolerance,angletolerance,commargs))
         {
-            std::cerr << "Warning: negative values for a1, a2 don't make any sense. Putting them back in order." << std::endl;
-            commargs[ALPHA]=180-commargs[ALPHA];
+            retval=-1;
+            continue;
         }
-        for(i=B1MIN;i<=B2MAX;i++)
+        sanitize(commargs);
+        if(handler(commargs)!=0)
         {
-            commargs[i]=fabs(commargs[i]);
+            retval=-1;
         }
-        commargs[A1]=fabs(commargs[A1]);
-        commargs[A2]=fabs(commargs[A2]);
+    }
+    return(retval);
+}
 
-        commargs[BETAMIN]=(commargs[BETAMIN]-360*floor(commargs[BETAMIN]/360.0))*M_PI/180.0;
-        commargs[BETAMAX]=(commargs[BETAMAX]-360*floor(commargs[BETAMAX]/360.0))*M_PI/180.0;
-        commargs[ALPHA]=(commargs[ALPHA]-360*floor(commargs[ALPHA]/360.0))*M_PI/180.0;
+//one solve of a parallel run
+struct workitem
+{
+    double commargs[9];
+    long batchentry; //-1 outside of batches
+    bool newentry; //the first item of its batch entry
+    long sweeppoint; //-1 outside of sweeps
+    bool solve; //false for an entry that has nothing to solve, but still shows up in the output
+};
 
-        for(i=0;i<3;i++)
+//what runjob() would do, as items for runparallel(). Only plain solves and sweeps, see main().
+static int queuejob(const double commargs[9], long batchentry, const runoptions &options, std::vector<workitem> &items)
+{
+    workitem item;
+    item.batchentry=batchentry;
+    item.newentry=(batchentry>=0);
+    item.sweeppoint=-1;
+    item.solve=true;
+    std::copy(commargs,commargs+9,item.commargs);
+    if(options.sweepcount==0)
+    {
+        items.push_back(item);
+        return(0);
+    }
+    for(unsigned int k=0;k<options.sweepcount;k++)
+    {
+        item.commargs[B1MIN]=commargs[B1MIN]+k*options.sweepstep;
+        item.commargs[B1MAX]=commargs[B1MAX]+k*options.sweepstep;
+        if(item.commargs[B1MIN]<=0.0)
         {
-            if(commargs[2*i+3]>commargs[2*i+1+3])
+            cerr << "Sweep point " << k << " has a non-positive b1min, stopping." << std::endl;
+            if(k==0 && item.newentry)
             {
-                swapper = commargs[2*i+3];
-                commargs[2*i+3] = commargs[2*i+1+3];
-                commargs[2*i+1+3] = swapper;
+                item.solve=false;
+                items.push_back(item);
             }
+            return(-1);
         }
-        if(commargs[BETAMAX]-commargs[BETAMIN]>M_PI)
+        item.sweeppoint=k;
+        items.push_back(item);
+        item.newentry=false;
+    }
+    return(0);
+}
+
+//solves the items on several threads, each with its own copy of prototype, and writes them in order.
+static void runparallel(const std::vector<workitem> &items, unsigned int threads, const matchsolver &prototype, resultwriter &writer, const runoptions &options)
+{
+    struct workslot
+    {
+        matchsolver solver;
+        solveanswer answer;
+    };
+    workslot empty;
+    empty.solver=prototype;
+    //two slots per thread: one being written, one being solved. More would only hold more results in memory.
+    reorderbuffer<workslot> buffer(2*threads,empty);
+    std::atomic<unsigned long> next(0);
+    auto worker=[&]()
+    {
+        for(unsigned long i=next++;i<items.size();i=next++)
+        {
+            workslot &slot=buffer.acquire(i);
+            if(items[i].solve)
+            {
+                slot.solver.setparams(items[i].commargs);
+                solveonly(slot.solver,options,slot.answer);
+            }
+            buffer.publish(i);
+        }
+    };
+    std::vector<std::thread> pool;
+    for(unsigned int t=0;t<threads;t++)
+    {
+        pool.push_back(std::thread(worker));
+    }
+    for(size_t i=0;i<items.size();i++)
+    {
+        workslot &slot=buffer.next();
+        const workitem &item=items[i];
+        if(item.newentry)
+        {
+            writer.writebatchentry(item.batchentry);
+        }
+        if(item.sweeppoint>=0)
+        {
+            writer.writesweeppoint(item.sweeppoint,item.commargs[B1MIN],item.commargs[B1MAX]);
+        }
+        if(item.solve)
         {
-            std::cerr << "Warning: Sanitized betamax and betamin are more than 180 degrees apart.\n\tThat's probably not what you intended. betamax: " << commargs[BETAMAX]*180.0/M_PI << ", betamin: " << commargs[BETAMIN]*180.0/M_PI << "\n\tAre you trying to use put a beta range including zero? Edit the source code for that..." << std::endl;
+            writeanswer(slot.solver,writer,options,slot.answer);
         }
-        //Now the input should be sanitized.
-        //determine number of ranges for px, qx
-        //as sin(alpha) can be negative -> fabs
+        buffer.release();
+    }
+    for(size_t t=0;t<pool.size();t++)
+    {
+        pool[t].join();
+    }
+}
 
-        //if the substrate is hexagonal, we need to run the whole calculation twice: Once for the lattice vectors given by the user, and once for the angle changed by 60°.
-        //don't judge me by the following line, it's there because I'm too lazy to care about the floating point precision.
-        char loops=1;
-        if(commargs[ALPHA]==60.0*M_PI/180.0 || commargs[ALPHA]==120.0*M_PI/180.0 || commargs[ALPHA]==240.0*M_PI/180.0 || commargs[ALPHA]==300.0*M_PI/180.0)
-        {
-            loops=2;
-            commargs[ALPHA]=60.0*M_PI/180.0;
-        }
-        angleset coincident;
-        angleset commensurate;
-        char hexcounter;
-        for(hexcounter=0;hexcounter<loops;++hexcounter)
-        {
-            unsigned int maxn,maxm;
-            maxn=fabs(commargs[B1MAX]/(commargs[A1]*sin(commargs[ALPHA])));
-            maxm=fabs(commargs[B2MAX]/(commargs[A1]*sin(commargs[ALPHA])));
-            //solutions run from -maxn to maxn, and from -maxm to maxm.
-            //Due to the ambiguity of asin, two solutions exist for each value of n and m
-            //This means, that (2*maxn+1)*2 solutions exist, the same for m.
-            angleset pxranges;
-            pxranges.reserve(4*maxn+2); //reserve memory, so adding stuff is faster...
-            angleset qxranges;
-            qxranges.reserve(4*maxm+2);
+//turns the binary angles of an archive back into an angleset
+static void toangleset(const std::vector<uint32_t> &values, bool fullcircle, angleset &target)
+{
+    target.clear();
+    if(fullcircle)
+    {
+        anglerange circle;
+        circle.setcircle(true);
+        target.add(circle);
+        return;
+    }
+    for(size_t j=0;j+1<values.size();j+=2)
+    {
+        target.add(values[j]*(2.0*M_PI/4294967296.0),values[j+1]*(2.0*M_PI/4294967296.0));
+    }
+}
 
-            //up to now it was more or less dull C code. Now comes the first real difference:
-            //As asin changes sign together with its argument, one has to treat positive and negative n differently
-            //first the special case n=0:
-            pxranges.add(commargs[ALPHA],commargs[ALPHA]);
-            pxranges.add(commargs[ALPHA] - M_PI, commargs[ALPHA] - M_PI);
-            //now the slightly more difficult case: n>0
-            for(i=1;i<=maxn;i++){
-                //while factoring out the asin doesn't improve performance much - it's only used twice, it improves readability, as the important thing in the formulas below
-                //are the signs.
-                //the fmax and fmin are there, because maxn was calculated using B1MAX. Witht B1MIN the argument of arcsine can very well be outside its defined range.
-                double asina1b1min=asin(fmax(-1.0,fmin(1.0,i*commargs[A1]*sin(commargs[ALPHA])/commargs[B1MIN])));
-                double asina1b1max=asin(i*commargs[A1]*sin(commargs[ALPHA])/commargs[B1MAX]);
-                //we need to consider that sin(alpha) can be negative. In that case the sign of the asin will change as well.
-                if(asina1b1min>=0)
-                {
-                    pxranges.add(
-                                commargs[ALPHA] - asina1b1min,
-                                commargs[ALPHA] - asina1b1max
-                                );
-                    pxranges.add(
-                                commargs[ALPHA] - M_PI + asina1b1max,
-                                commargs[ALPHA] - M_PI + asina1b1min
-                                );
-                    //and the most difficult case: n<0
-                    //here the arcsin is negative. as i is positive, I'll just change the sign in front of the arcsin.
-                    pxranges.add(
-                                commargs[ALPHA] + asina1b1max,
-                                commargs[ALPHA] + asina1b1min
-                                );
-                    pxranges.add(
-                                commargs[ALPHA] - M_PI - asina1b1min,
-                                commargs[ALPHA] - M_PI - asina1b1max
-                                );
-                }
-                else
+//prints record index of an archive as text, or all of them if index is negative.
+static int extractarchive(const char *name, long index, textwriter &writer)
+{
+    archivereader reader;
+    if(!reader.open(name))
+    {
+        cerr << "Cannot read archive " << name << std::endl;
+        return(-1);
+    }
+    uint64_t first = index<0 ? 0 : index;
+    uint64_t last = index<0 ? reader.count() : index+1;
+    if(last>reader.count())
+    {
+        cerr << "Archive " << name << " only has " << reader.count() << " records." << std::endl;
+        return(-1);
+    }
+    archiverecord record;
+    angleset coincident, commensurate;
+    for(uint64_t k=first;k<last;k++)
+    {
+        if(!reader.read(k,record))
+        {
+            cerr << "Record " << k << " of archive " << name << " is broken." << std::endl;
+            return(-1);
+        }
+        if(record.flags&ARC_BATCH)
+        {
+            writer.writebatchentry(record.batchindex);
+        }
+        if(record.flags&ARC_SWEEP)
+        {
+            writer.writesweeppoint(record.index,record.params[B1MIN],record.params[B1MAX]);
+        }
+        if(record.flags&ARC_EXTENSION)
+        {
+            writer.writeextension(record.params[B1MAX],record.params[B2MAX]);
+        }
+        if(record.flags&ARC_SHELL)
+        {
+            writer.writeshell(record.index,!(record.flags&ARC_PARTIAL));
+        }
+        toangleset(record.coincident,record.flags&ARC_COINCIDENT_FULLCIRCLE,coincident);
+        toangleset(record.commensurate,record.flags&ARC_COMMENSURATE_FULLCIRCLE,commensurate);
+        writer.writesets(coincident,commensurate);
+    }
+    writer.flush();
+    return(0);
+}
+
+static void printusage(const char *name)
+{
+    cout << "Usage: " << name << " [options] a1 a2 alpha b1min b1max b2min b2max betamin betamax" << std::endl;
+    cout << "       " << name << " [options] --batch file" << std::endl;
+    cout << "       " << name << " [options] --import file" << std::endl;
+    cout << "       " << name << " [--full-precision] --archive-extract file index|all" << std::endl << "Please input angles in degrees." << std::endl;
+    cout << "Options:" << std::endl;
+    cout << "  --extend b1max b2max   after solving, grow b1max and b2max to the given values and print the results again." << std::endl;
+    cout << "                         Only the new part is calculated. Can be given several times, values have to grow." << std::endl;
+    cout << "  --sweep-b1 step count  solve count times, shifting b1min and b1max by step each time." << std::endl;
+    cout << "  --batch file           read the nine numbers from file, one set per line. - is standard input." << std::endl;
+    cout << "  --import file          like --batch, but each line is: substratefile h k l adlayerfile h k l, with CIF or" << std::endl;
+    cout << "                         POSCAR files and the Miller indices of the surface planes." << std::endl;
+    cout << "  --import-tolerance percent degrees   tolerance of the imported adlayer cell. Default: 1 1." << std::endl;
+    cout << "  --asin-table           use a precomputed, outwards rounded arcsine table. Default in sweeps." << std::endl;
+    cout << "  --no-asin-table        always evaluate asin directly." << std::endl;
+    cout << "  --full-precision       print the shortest representation that reads back to the exact result." << std::endl;
+    cout << "  --format name          output format: text (default), binary, jsonl, archive or shm." << std::endl;
+    cout << "  --archive-extract file index|all   print one or all records of an archive as text." << std::endl;
+    cout << "  --binary-angles        binary and shm formats: store endpoints as 32 bit binary angles instead of doubles." << std::endl;
+    cout << "  --output file          write results to file instead of standard output. For shm: the shared memory name." << std::endl;
+    cout << "  --shm-ring slots bytes shm format only: number and size of the slots of the ring. Default: 64 65536." << std::endl;
+    cout << "  --anytime seconds      solve for indices up to 4, 8, 16, ... and print each of these results, until" << std::endl;
+    cout << "                         all indices are done, or the next step wouldn't finish within the given time." << std::endl;
+    cout << "  --query exists|count   only tell if there are commensurate matches, or how many ranges of them." << std::endl;
+    cout << "                         Faster than a full solve, but not available for the archive format." << std::endl;
+    cout << "  --min-width degrees    leave out ranges narrower than this, and skip what can only give such ranges." << std::endl;
+    cout << "  --strain relative      accept films strained by up to this much (0.01 for 1%) in b1, b2 and beta." << std::endl;
+    cout << "  --max-det n            commensurate matches only with supercells of at most n substrate cells." << std::endl;
+    cout << "  --max-order d          text and jsonl only: also matrix entries k/d' with d'<=d, and tag each range with" << std::endl;
+    cout << "                         the smallest denominator it needs. Default: 1, integers only." << std::endl;
+    cout << "  --top k                only print the k widest coincident and commensurate ranges." << std::endl;
+    cout << "  --rank width|misfit    with --top: keep the widest ranges, or those with the smallest misfit. Default: width." << std::endl;
+    cout << "  --best                 text and jsonl only: the angle with the smallest misfit inside each range, and that misfit." << std::endl;
+    cout << "  --engine ranges|enumerate|scan   enumerate: commensurate matches only, as exact angles, found by listing" << std::endl;
+    cout << "                         the integer epitaxy matrices. Much faster for small supercells. scan: brute force" << std::endl;
+    cout << "                         on a grid over theta, as a cross-check. Default: ranges." << std::endl;
+    cout << "  --scan-points n        grid points around the circle for the scan engine. Default: 360000." << std::endl;
+    cout << "  --benchmark            instead of results, print how long the engines take, and if they agree." << std::endl;
+    cout << "  --provenance           text and jsonl only: list the epitaxy matrices (px qx qy py) behind each range." << std::endl;
+    cout << "  --multiplicity         text and jsonl only: also print how many index combinations hit each angle." << std::endl;
+    cout << "  --save-families file   after the run, save the px and qy ranges of the last solve to file." << std::endl;
+    cout << "  --load-families file   take px and qy from file instead of generating them, whenever a1, a2, alpha," << std::endl;
+    cout << "                         b1min, b1max, --min-width and the asin table are those they were saved with." << std::endl;
+    cout << "  --threads n            solve sweep points and batch entries on n threads. Results still come in order." << std::endl;
+    cout << "  --stream               text and jsonl only: print each range as soon as it is final, while still solving." << std::endl;
+    cout << "  --first n              text and jsonl only: print the first n ranges, in the order of --stream." << std::endl;
+    cout << "  --from degrees         with --first: start looking at this angle instead of 0." << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    //This is largely a copy of what I already did in plain C.
+    //There will be a lot of plain C code here, so don't look too close...
+    double commargs[9];
+    runoptions options;
+    options.sweepstep=0.0;
+    options.sweepcount=0;
+    options.stream=0;
+    options.streamsectors=64;
+    options.anytime=0.0;
+    options.query=runoptions::QUERY_NONE;
+    options.top=0;
+    options.rank=runoptions::RANK_WIDTH;
+    options.first=0;
+    options.from=0.0;
+    options.engine=runoptions::ENGINE_RANGES;
+    options.scanpoints=360000;
+    bool benchmark=false;
+    bool stream=false;
+    unsigned int threads=1;
+    int usetable=-1; //-1: default, that is: only in sweeps
+    double minwidth=0.0;
+    double strain=0.0;
+    unsigned int maxdeterminant=0;
+    unsigned int maxorder=1;
+    bool fullprecision=false;
+    const char *format="text";
+    bool binaryangles=false;
+    const char *outputname=0;
+    unsigned int shmslots=64, shmslotsize=65536;
+    const char *batchname=0;
+    const char *importname=0;
+    double importtolerance[2]={1.0,1.0};
+    const char *archivename=0;
+    long archiveindex=-1;
+    bool provenance=false;
+    bool multiplicity=false;
+    bool best=false;
+    const char *savefamilies=0;
+    const char *loadfamilies=0;
+    int positional=0;
+    int i;
+    for(i=1;i<argc;i++)
+    {
+        //options start with a double dash, so negative numbers are still numbers.
+        if(strncmp(argv[i],"--",2)==0)
+        {
+            if(strcmp(argv[i],"--extend")==0 && i+2<argc)
+            {
+                double b1, b2;
+                sscanf(argv[++i],"%lf",&b1);
+                sscanf(argv[++i],"%lf",&b2);
+                options.extensions.push_back(fabs(b1));
+                options.extensions.push_back(fabs(b2));
+            }
+            else if(strcmp(argv[i],"--sweep-b1")==0 && i+2<argc)
+            {
+                sscanf(argv[++i],"%lf",&options.sweepstep);
+                sscanf(argv[++i],"%u",&options.sweepcount);
+            }
+            else if(strcmp(argv[i],"--batch")==0 && i+1<argc)
+            {
+                batchname=argv[++i];
+            }
+            else if(strcmp(argv[i],"--import")==0 && i+1<argc)
+            {
+                importname=argv[++i];
+            }
+            else if(strcmp(argv[i],"--import-tolerance")==0 && i+2<argc)
+            {
+                sscanf(argv[++i],"%lf",&importtolerance[0]);
+                sscanf(argv[++i],"%lf",&importtolerance[1]);
+            }
+            else if(strcmp(argv[i],"--archive-extract")==0 && i+2<argc)
+            {
+                archivename=argv[++i];
+                ++i;
+                archiveindex = strcmp(argv[i],"all")==0 ? -1 : atol(argv[i]);
+            }
+            else if(strcmp(argv[i],"--asin-table")==0)
+            {
+                usetable=1;
+            }
+            else if(strcmp(argv[i],"--no-asin-table")==0)
+            {
+                usetable=0;
+            }
+            else if(strcmp(argv[i],"--full-precision")==0)
+            {
+                fullprecision=true;
+            }
+            else if(strcmp(argv[i],"--format")==0 && i+1<argc)
+            {
+                format=argv[++i];
+            }
+            else if(strcmp(argv[i],"--binary-angles")==0)
+            {
+                binaryangles=true;
+            }
+            else if(strcmp(argv[i],"--output")==0 && i+1<argc)
+            {
+                outputname=argv[++i];
+            }
+            else if(strcmp(argv[i],"--shm-ring")==0 && i+2<argc)
+            {
+                sscanf(argv[++i],"%u",&shmslots);
+                sscanf(argv[++i],"%u",&shmslotsize);
+            }
+            else if(strcmp(argv[i],"--anytime")==0 && i+1<argc)
+            {
+                sscanf(argv[++i],"%lf",&options.anytime);
+            }
+            else if(strcmp(argv[i],"--query")==0 && i+1<argc)
+            {
+                ++i;
+                if(strcmp(argv[i],"exists")==0)
                 {
-                    //just as above, but with upper and lower limits switched
-                    pxranges.add(
-                                commargs[ALPHA] - asina1b1max,
-                                commargs[ALPHA] - asina1b1min
-                                );
-                    pxranges.add(
-                                commargs[ALPHA] - M_PI + asina1b1min,
-                                commargs[ALPHA] - M_PI + asina1b1max
-                                );
-                    //n<0
-                    pxranges.add(
-                                commargs[ALPHA] + asina1b1min,
-                                commargs[ALPHA] + asina1b1max
-                                );
-                    pxranges.add(
-                                commargs[ALPHA] - M_PI - asina1b1max,
-                                commargs[ALPHA] - M_PI - asina1b1min
-                                );
+                    options.query=runoptions::QUERY_EXISTS;
                 }
-            }
-            //same nonsense for qxranges
-            //first the easy part: m=0;
-            qxranges.add(
-                        commargs[ALPHA] - commargs[BETAMAX],
-                        commargs[ALPHA] - commargs[BETAMIN]
-                        );
-            qxranges.add(
-                        commargs[ALPHA] - commargs[BETAMAX] - M_PI,
-                        commargs[ALPHA] - commargs[BETAMIN] - M_PI
-                        );
-            //now the slightly more difficult case: m>0;
-            for(i=1;i<=maxm;i++){
-                //also here, the asin values are factored out for improved readability.
-                double asina1b2min=asin(fmax(fmin(i*commargs[A1]*sin(commargs[ALPHA])/commargs[B2MIN],1.0),-1.0));
-                double asina1b2max=asin(i*commargs[A1]*sin(commargs[ALPHA])/commargs[B2MAX]);
-                //same here: keep in mind that sin(alpha) can be negative:
-                if(asina1b2min>=0)
+                else if(strcmp(argv[i],"count")==0)
                 {
-                    qxranges.add(
-                                commargs[ALPHA] - commargs[BETAMAX] - asina1b2min,
-                                commargs[ALPHA] - commargs[BETAMIN] - asina1b2max
-                                );
-                    qxranges.add(
-                                commargs[ALPHA] - commargs[BETAMAX] - M_PI + asina1b2max,
-                                commargs[ALPHA] - commargs[BETAMIN] - M_PI + asina1b2min
-                                );
-                    //and last, but not leasst, the most difficult, m<0 - here the arcsin is negative;
-                    //as i is positive, I'll just change the sign in front of the arcsin.
-                    qxranges.add(
-                                commargs[ALPHA] - commargs[BETAMAX] + asina1b2max,
-                                commargs[ALPHA] - commargs[BETAMIN] + asina1b2min
-                                );
-                    qxranges.add(
-                                commargs[ALPHA] - commargs[BETAMAX] - M_PI - asina1b2min,
-                                commargs[ALPHA] - commargs[BETAMIN] - M_PI - asina1b2max
-                                );
+                    options.query=runoptions::QUERY_COUNT;
                 }
                 else
                 {
-                    qxranges.add(
-                                commargs[ALPHA] - commargs[BETAMAX] - asina1b2max,
-                                commargs[ALPHA] - commargs[BETAMIN] - asina1b2min
-                                );
-                    qxranges.add(
-                                commargs[ALPHA] - commargs[BETAMAX] - M_PI + asina1b2min,
-                                commargs[ALPHA] - commargs[BETAMIN] - M_PI + asina1b2max
-                                );
-                    //m<0
-                    qxranges.add(
-                                commargs[ALPHA] - commargs[BETAMAX] + asina1b2min,
-                                commargs[ALPHA] - commargs[BETAMIN] + asina1b2max
-                                );
-                    qxranges.add(
-                                commargs[ALPHA] - commargs[BETAMAX] - M_PI - asina1b2max,
-                                commargs[ALPHA] - commargs[BETAMIN] - M_PI - asina1b2min
-                                );
+                    cerr << "Unknown query: " << argv[i] << std::endl;
+                    return(-1);
                 }
             }
-            //Calculate the overlap between these two:
-            angleset xoverlaps=pxranges.overlap(qxranges);
-
-            //ok, same thing for qy, py:
-            //I know that this is wasteful regarding RAM, but well, we're still talking about bytes, not about megabytes ;-)
-            unsigned int maxo, maxp;
-            maxo=fabs(commargs[B1MAX]/(commargs[A2]*sin(commargs[ALPHA])));
-            maxp=fabs(commargs[B2MAX]/(commargs[A2]*sin(commargs[ALPHA])));
-            angleset qyranges;
-            qyranges.reserve(4*maxo+2);
-            angleset pyranges;
-            pyranges.reserve(4*maxp+2);
-
-            //now let's start with qyranges. As previously we need to consider the "sign" of o,p, and sin(alpha)
-            //first: o=0
-            qyranges.add(0.0,0.0);
-            qyranges.add(M_PI,M_PI);
-            for(i=1;i<=maxo;i++)
-            {
-                //also here: factor out the asin for improved readability.
-                double asina2b1min = asin(fmax(-1.0,fmin(1.0,i*commargs[A2]*sin(commargs[ALPHA])/commargs[B1MIN])));
-                double asina2b1max = asin(i*commargs[A2]*sin(commargs[ALPHA])/commargs[B1MAX]);
-                //is sin(alpha)>0?
-                if(asina2b1max>=0)
+            else if(strcmp(argv[i],"--min-width")==0 && i+1<argc)
+            {
+                sscanf(argv[++i],"%lf",&minwidth);
+            }
+            else if(strcmp(argv[i],"--strain")==0 && i+1<argc)
+            {
+                sscanf(argv[++i],"%lf",&strain);
+            }
+            else if(strcmp(argv[i],"--max-det")==0 && i+1<argc)
+            {
+                sscanf(argv[++i],"%u",&maxdeterminant);
+            }
+            else if(strcmp(argv[i],"--max-order")==0 && i+1<argc)
+            {
+                sscanf(argv[++i],"%u",&maxorder);
+            }
+            else if(strcmp(argv[i],"--top")==0 && i+1<argc)
+            {
+                sscanf(argv[++i],"%u",&options.top);
+            }
+            else if(strcmp(argv[i],"--engine")==0 && i+1<argc)
+            {
+                ++i;
+                if(strcmp(argv[i],"enumerate")==0)
                 {
-                    //case: o>0
-                    qyranges.add(
-                                asina2b1max,
-                                asina2b1min
-                                );
-                    qyranges.add(
-                                M_PI - asina2b1min,
-                                M_PI - asina2b1max
-                                );
-                    //case: o<0
-                    qyranges.add(
-                                -asina2b1min,
-                                -asina2b1max
-                                );
-                    qyranges.add(
-                                M_PI + asina2b1max,
-                                M_PI + asina2b1min
-                                );
+                    options.engine=runoptions::ENGINE_ENUMERATE;
                 }
-                else
+                else if(strcmp(argv[i],"scan")==0)
+                {
+                    options.engine=runoptions::ENGINE_SCAN;
+                }
+                else if(strcmp(argv[i],"ranges")!=0)
                 {
-                    //case: o>0
-                    qyranges.add(
-                                asina2b1min,
-                                asina2b1max
-                                );
-                    qyranges.add(
-                                M_PI - asina2b1max,
-                                M_PI - asina2b1min
-                                );
-                    //case: o<0
-                    qyranges.add(
-                                -asina2b1max,
-                                -asina2b1min
-                                );
-                    qyranges.add(
-                                M_PI + asina2b1min,
-                                M_PI + asina2b1max
-                                );
+                    cerr << "Unknown engine: " << argv[i] << std::endl;
+                    return(-1);
                 }
             }
-            //that was too easy. Probably it's buggy as hell...
-            //now to py
-            pyranges.add(
-                        -commargs[BETAMAX],
-                        -commargs[BETAMIN]
-                        );
-            pyranges.add(
-                        M_PI - commargs[BETAMAX],
-                        M_PI - commargs[BETAMIN]
-                        );
-            for(i=1;i<=maxp;i++)
-            {
-                //and again: readability
-                double asina2b2min = asin(fmax(-1.0,fmin(1.0,i*commargs[A2]*sin(commargs[ALPHA])/commargs[B2MIN])));
-                double asina2b2max = asin(i*commargs[A2]*sin(commargs[ALPHA])/commargs[B2MAX]);
-                if(asina2b2max>=0)
+            else if(strcmp(argv[i],"--scan-points")==0 && i+1<argc)
+            {
+                sscanf(argv[++i],"%u",&options.scanpoints);
+            }
+            else if(strcmp(argv[i],"--benchmark")==0)
+            {
+                benchmark=true;
+            }
+            else if(strcmp(argv[i],"--provenance")==0)
+            {
+                provenance=true;
+            }
+            else if(strcmp(argv[i],"--multiplicity")==0)
+            {
+                multiplicity=true;
+            }
+            else if(strcmp(argv[i],"--best")==0)
+            {
+                best=true;
+            }
+            else if(strcmp(argv[i],"--rank")==0 && i+1<argc)
+            {
+                ++i;
+                if(strcmp(argv[i],"misfit")==0)
                 {
-                    //case: p>0
-                    pyranges.add(
-                                asina2b2max - commargs[BETAMAX],
-                                asina2b2min - commargs[BETAMIN]
-                                );
-                    pyranges.add(
-                                M_PI - asina2b2min - commargs[BETAMAX],
-                                M_PI - asina2b2max - commargs[BETAMIN]
-                                );
-                    //case: p<0
-                    pyranges.add(
-                                -asina2b2min - commargs[BETAMAX],
-                                -asina2b2max - commargs[BETAMIN]
-                                );
-                    pyranges.add(
-                                M_PI + asina2b2max - commargs[BETAMAX],
-                                M_PI + asina2b2min - commargs[BETAMIN]
-                                );
+                    options.rank=runoptions::RANK_MISFIT;
                 }
-                else
+                else if(strcmp(argv[i],"width")!=0)
                 {
-                    //ok, here the asin is of opposite sign!
-                    //case p>0
-                    pyranges.add(
-                                asina2b2min - commargs[BETAMAX],
-                                asina2b2max - commargs[BETAMIN]
-                                );
-                    pyranges.add(
-                                M_PI - asina2b2max - commargs[BETAMAX],
-                                M_PI - asina2b2min - commargs[BETAMIN]
-                                );
-                    //case: p<0
-                    pyranges.add(
-                                -asina2b2max - commargs[BETAMAX],
-                                -asina2b2min - commargs[BETAMIN]
-                                );
-                    pyranges.add(
-                                M_PI + asina2b2min - commargs[BETAMAX],
-                                M_PI + asina2b2max - commargs[BETAMIN]
-                                );
+                    cerr << "Unknown ranking: " << argv[i] << std::endl;
+                    return(-1);
                 }
             }
-            //99 bottles of bugs on the wall, 99 bottles of bugs. You get one down and fix it up, 99 bottles of bugs...
-            //100 bottles of bugs on the wall, 100 bottles of bugs....
-
-            angleset yoverlaps = pyranges.overlap(qyranges);
-
-
-            coincident.add(xoverlaps);
-            coincident.add(yoverlaps);
-
-            //to be a commensurate match, an angle has to be in both, x- and yoverlaps
-            commensurate.add(xoverlaps.overlap(yoverlaps));
+            else if(strcmp(argv[i],"--save-families")==0 && i+1<argc)
+            {
+                savefamilies=argv[++i];
+            }
+            else if(strcmp(argv[i],"--load-families")==0 && i+1<argc)
+            {
+                loadfamilies=argv[++i];
+            }
+            else if(strcmp(argv[i],"--stream")==0)
+            {
+                stream=true;
+            }
+            else if(strcmp(argv[i],"--threads")==0 && i+1<argc)
+            {
+                sscanf(argv[++i],"%u",&threads);
+            }
+            else if(strcmp(argv[i],"--first")==0 && i+1<argc)
+            {
+                sscanf(argv[++i],"%u",&options.first);
+            }
+            else if(strcmp(argv[i],"--from")==0 && i+1<argc)
+            {
+                sscanf(argv[++i],"%lf",&options.from);
+                options.from*=M_PI/180.0;
+            }
+            else
+            {
+                cerr << "Unknown option or missing value: " << argv[i] << std::endl;
+                printusage(argv[0]);
+                return(-1);
+            }
+        }
+        else if(positional<9)
+        {
+            //what is this stringstreams stuff everyone is hyped about?!?
+            sscanf(argv[i],"%lf",&(commargs[positional++]));
+        }
+        else
+        {
+            positional++;
+        }
+    }
+    if(archivename)
+    {
+        outbuffer stdoutbuffer(1);
+        textwriter writer(stdoutbuffer,fullprecision);
+        int retval=extractarchive(archivename,archiveindex,writer);
+        if(!stdoutbuffer.flush())
+        {
+            cerr << "Cannot write the results: " << strerror(stdoutbuffer.geterror()) << std::endl;
+            retval=-1;
+        }
+        return(retval);
+    }
+    if(positional!=(batchname || importname ? 0 : 9) || (batchname && importname))
+    {
+        printusage(argv[0]);
+        return(-1);
+    }
+    else if(options.sweepcount>0 && !options.extensions.empty())
+    {
+        cerr << "--extend and --sweep-b1 cannot be combined." << std::endl;
+        return(-1);
+    }
+    else if(options.anytime>0.0 && (options.sweepcount>0 || !options.extensions.empty() || stream))
+    {
+        cerr << "--anytime cannot be combined with --sweep-b1, --extend or --stream." << std::endl;
+        return(-1);
+    }
+    else if(options.query!=runoptions::QUERY_NONE && (!options.extensions.empty() || stream || options.anytime>0.0 || strcmp(format,"archive")==0))
+    {
+        cerr << "--query cannot be combined with --extend, --stream, --anytime or the archive format." << std::endl;
+        return(-1);
+    }
+    else if(options.top>0 && (!options.extensions.empty() || stream || options.anytime>0.0 || options.query!=runoptions::QUERY_NONE))
+    {
+        cerr << "--top cannot be combined with --extend, --stream, --anytime or --query." << std::endl;
+        return(-1);
+    }
+    else if(options.first>0 && (!options.extensions.empty() || stream || options.anytime>0.0 || options.query!=runoptions::QUERY_NONE || options.top>0))
+    {
+        cerr << "--first cannot be combined with --extend, --stream, --anytime, --query or --top." << std::endl;
+        return(-1);
+    }
+    else if(threads>1 && (!options.extensions.empty() || stream || options.anytime>0.0 || options.first>0))
+    {
+        //those need the writer while solving, or solve one job in several steps.
+        cerr << "--threads cannot be combined with --extend, --stream, --anytime or --first." << std::endl;
+        return(-1);
+    }
+    else if(options.engine!=runoptions::ENGINE_RANGES && (!options.extensions.empty() || stream || options.anytime>0.0 || options.query!=runoptions::QUERY_NONE || options.top>0 || options.first>0 || provenance || minwidth!=0.0 || strain!=0.0))
+    {
+        cerr << "--engine " << (options.engine==runoptions::ENGINE_SCAN ? "scan" : "enumerate")
+             << " cannot be combined with --extend, --stream, --anytime, --query, --top, --first, --provenance, --min-width or --strain." << std::endl;
+        return(-1);
+    }
+    else if(!(strain>=0.0 && strain<1.0))
+    {
+        cerr << "--strain has to be at least 0, and less than 1." << std::endl;
+        return(-1);
+    }
+    else if(maxdeterminant>0 && (!options.extensions.empty() || stream || options.anytime>0.0 || options.query!=runoptions::QUERY_NONE || options.top>0 || options.first>0 || options.engine!=runoptions::ENGINE_RANGES || benchmark))
+    {
+        //only a full solve has the indices of the matches.
+        cerr << "--max-det cannot be combined with --extend, --stream, --anytime, --query, --top, --first, --engine or --benchmark." << std::endl;
+        return(-1);
+    }
+    else if(maxorder==0)
+    {
+        cerr << "--max-order has to be at least 1." << std::endl;
+        return(-1);
+    }
+    else if(maxorder>1 && (!options.extensions.empty() || stream || options.anytime>0.0 || options.query!=runoptions::QUERY_NONE || options.top>0 || options.first>0 || options.engine!=runoptions::ENGINE_RANGES || benchmark || provenance || maxdeterminant>0))
+    {
+        //the fractions are added after a plain solve, which the other modes don't do. Provenance and the
+        //determinant only know integer matrices.
+        cerr << "--max-order cannot be combined with --extend, --stream, --anytime, --query, --top, --first, --engine, --benchmark, --provenance or --max-det." << std::endl;
+        return(-1);
+    }
+    else if(maxorder>1 && strcmp(format,"text")!=0 && strcmp(format,"jsonl")!=0)
+    {
+        cerr << "--max-order only works with the text and jsonl formats." << std::endl;
+        return(-1);
+    }
+    else if(options.scanpoints==0)
+    {
+        cerr << "--scan-points needs at least one point." << std::endl;
+        return(-1);
+    }
+    else if(benchmark && (!options.extensions.empty() || options.sweepcount>0 || stream || options.anytime>0.0 || options.query!=runoptions::QUERY_NONE || options.top>0 || options.first>0 || threads>1 || strain!=0.0))
+    {
+        //the other engines take the windows as they are, they'd disagree with strained ranges.
+        cerr << "--benchmark cannot be combined with --extend, --sweep-b1, --stream, --anytime, --query, --top, --first, --threads or --strain." << std::endl;
+        return(-1);
+    }
+    else if(provenance && (!options.extensions.empty() || stream || options.anytime>0.0 || options.query!=runoptions::QUERY_NONE || options.top>0 || options.first>0))
+    {
+        //only a plain solve keeps track of the indices.
+        cerr << "--provenance cannot be combined with --extend, --stream, --anytime, --query, --top or --first." << std::endl;
+        return(-1);
+    }
+    else if(provenance && strcmp(format,"text")!=0 && strcmp(format,"jsonl")!=0)
+    {
+        cerr << "--provenance only works with the text and jsonl formats." << std::endl;
+        return(-1);
+    }
+    else if(multiplicity && (!options.extensions.empty() || stream || options.anytime>0.0 || options.query!=runoptions::QUERY_NONE || options.top>0 || options.first>0 || options.engine!=runoptions::ENGINE_RANGES || benchmark || maxdeterminant>0 || maxorder>1))
+    {
+        //counted is what a plain solve generates, the determinant limit and the fractions come after that.
+        cerr << "--multiplicity cannot be combined with --extend, --stream, --anytime, --query, --top, --first, --engine, --benchmark, --max-det or --max-order." << std::endl;
+        return(-1);
+    }
+    else if(multiplicity && strcmp(format,"text")!=0 && strcmp(format,"jsonl")!=0)
+    {
+        cerr << "--multiplicity only works with the text and jsonl formats." << std::endl;
+        return(-1);
+    }
+    else if(best && (stream || options.query!=runoptions::QUERY_NONE || options.first>0 || options.engine!=runoptions::ENGINE_RANGES || benchmark))
+    {
+        //only solve(), --top, extend() and refine() fit the ranges, at the end.
+        cerr << "--best cannot be combined with --stream, --query, --first, --engine or --benchmark." << std::endl;
+        return(-1);
+    }
+    else if(best && strcmp(format,"text")!=0 && strcmp(format,"jsonl")!=0)
+    {
+        cerr << "--best only works with the text and jsonl formats." << std::endl;
+        return(-1);
+    }
+    else if(options.rank!=runoptions::RANK_WIDTH && options.top==0)
+    {
+        cerr << "--rank only works with --top." << std::endl;
+        return(-1);
+    }
+    else if(savefamilies && (threads>1 || !options.extensions.empty() || options.anytime>0.0 || strain!=0.0 || maxdeterminant>0 || maxorder>1))
+    {
+        //the threads solve on copies of the solver, and extend() and anytime leave no complete families.
+        //Strained, capped or fractional ones aren't what the file says they are.
+        cerr << "--save-families cannot be combined with --threads, --extend, --anytime, --strain, --max-det or --max-order." << std::endl;
+        return(-1);
+    }
+    else if(strcmp(format,"text")!=0 && strcmp(format,"binary")!=0 && strcmp(format,"jsonl")!=0 && strcmp(format,"archive")!=0 && strcmp(format,"shm")!=0)
+    {
+        cerr << "Unknown output format: " << format << std::endl;
+        return(-1);
+    }
+    else if(strcmp(format,"shm")==0 && !outputname)
+    {
+        cerr << "The shm format needs a name for the shared memory object, given with --output." << std::endl;
+        return(-1);
+    }
+    else if((stream || options.first>0) && (strcmp(format,"binary")==0 || strcmp(format,"archive")==0 || strcmp(format,"shm")==0))
+    {
+        //binary and archive records need their counts up front, they can't stream.
+        cerr << "--stream and --first only work with the text and jsonl formats." << std::endl;
+        return(-1);
+    }
+    else
+    {
+        FILE *batchfile=0;
+        const char *listname = batchname ? batchname : importname;
+        if(listname)
+        {
+            batchfile = strcmp(listname,"-")==0 ? stdin : fopen(listname,"r");
+            if(!batchfile)
+            {
+                cerr << "Cannot open " << (batchname ? "batch" : "import") << " file " << listname << std::endl;
+                return(-1);
+            }
+        }
+        int outfd=1;
+        bool shm=(strcmp(format,"shm")==0);
+        if(outputname && !shm)
+        {
+            outfd=open(outputname,O_WRONLY|O_CREAT|O_TRUNC,0644);
+            if(outfd<0)
+            {
+                cerr << "Cannot open output file " << outputname << std::endl;
+                return(-1);
+            }
+        }
+        //results don't go through cout, but through a big buffer that is written in one go.
+        outbuffer resultbuffer(outfd);
+        std::unique_ptr<resultwriter> writerptr;
+        if(strcmp(format,"binary")==0)
+        {
+            writerptr.reset(new binarywriter(resultbuffer,binaryangles));
+        }
+        else if(strcmp(format,"jsonl")==0)
+        {
+            writerptr.reset(new jsonwriter(resultbuffer));
+        }
+        else if(strcmp(format,"archive")==0)
+        {
+            writerptr.reset(new archivewriter(resultbuffer));
+        }
+        else if(shm)
+        {
+            shmwriter *shmptr=new shmwriter(outputname,shmslots,shmslotsize,binaryangles);
+            writerptr.reset(shmptr);
+            if(!shmptr->isopen())
+            {
+                cerr << "Cannot create shared memory object " << outputname << std::endl;
+                return(-1);
+            }
+        }
+        else
+        {
+            writerptr.reset(new textwriter(resultbuffer,fullprecision));
+        }
+        resultwriter &writer=*writerptr;
+        if(stream || options.first>0)
+        {
+            options.stream=dynamic_cast<matchsink*>(writerptr.get());
+        }
 
-            //should there be a second run, we need to increase alpha by 60°.
-            commargs[ALPHA]+=M_PI/3.0;
+        matchsolver solver;
+        solver.setminwidth(fabs(minwidth)*M_PI/180.0);
+        solver.setstrain(strain);
+        solver.setmaxdeterminant(maxdeterminant);
+        solver.setmaxorder(maxorder);
+        solver.setprovenance(provenance);
+        solver.setcoverage(multiplicity);
+        solver.setbestangles(best);
+        if(usetable==1 || (usetable==-1 && options.sweepcount>0))
+        {
+            solver.setasintable(&asintable::shared());
+        }
+        //the solvers of the threads are copies of this one, so they get the families as well.
+        if(loadfamilies && !solver.loadfamilies(loadfamilies))
+        {
+            cerr << "Cannot read range families from " << loadfamilies << std::endl;
+            return(-1);
         }
-        //quick and dirrrty
-        coincident.sort();
-        commensurate.sort();
-        cout << "Coincident Matches:\n";
-        for_each(coincident.getrangesref().begin(),coincident.getrangesref().end(),[](anglerange i) {cout << i.getlower().getval()*180/M_PI << " " << i.getupper().getval()*180/M_PI << "\n"; });
-        cout << "Commensurate Matches:\n";
-        for_each(commensurate.getrangesref().begin(),commensurate.getrangesref().end(),[](anglerange i) {cout << i.getlower().getval()*180/M_PI << " " << i.getupper().getval()*180/M_PI << "\n"; });
+        int retval;
+        //with threads, everything is queued first, and solved afterwards.
+        std::vector<workitem> items;
+        unsigned int entry=0;
+        entryhandler handler;
+        if(benchmark)
+        {
+            handler=[&](const double entryargs[9]) { return(runbenchmark(entryargs,solver,entry++,options.scanpoints)); };
+        }
+        else if(threads>1)
+        {
+            handler=[&](const double entryargs[9]) { return(queuejob(entryargs,entry++,options,items)); };
+        }
+        else
+        {
+            handler=[&](const double entryargs[9]) { writer.writebatchentry(entry++); return(runjob(entryargs,solver,writer,options)); };
+        }
+        if(batchfile)
+        {
+            if(batchname)
+            {
+                retval=runbatch(batchfile,handler);
+            }
+            else
+            {
+                retval=runimport(batchfile,importtolerance[0],importtolerance[1],handler);
+            }
+            if(batchfile!=stdin)
+            {
+                fclose(batchfile);
+            }
+        }
+        else
+        {
+            sanitize(commargs);
+            //Now the input should be sanitized.
+            if(benchmark)
+            {
+                retval=runbenchmark(commargs,solver,0,options.scanpoints);
+            }
+            else
+            {
+                retval = threads>1 ? queuejob(commargs,-1,options,items) : runjob(commargs,solver,writer,options);
+            }
+        }
+        if(threads>1)
+        {
+            runparallel(items,threads,solver,writer,options);
+        }
+        if(savefamilies && !solver.savefamilies(savefamilies))
+        {
+            cerr << "Cannot save range families to " << savefamilies << std::endl;
+            retval=-1;
+        }
+        writer.finish();
+        //the writers flush as they go, a write that failed on the way is still in the buffer.
+        if(!resultbuffer.flush())
+        {
+            cerr << "Cannot write the results: " << strerror(resultbuffer.geterror()) << std::endl;
+            retval=-1;
+        }
+        return(retval);
     }
 }
-
@@ -0,0 +1,1651 @@
+/*
+ * LatticeMatch calculator - the actual solver
+ * Copyright (C) 2015 Andreas Grois
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ *
+ * This class holds everything that used to live in main(): the range families for px, qx, qy and py,
+ * their overlaps, and the resulting sets of coincident and commensurate matches.
+ * Keeping the intermediate families around allows to extend an already solved state when b1max or b2max
+ * grow, instead of redoing everything. Growing b1max by a band [oldb1max:newb1max] only adds ranges (every
+ * family is monotonic in b), so the new ranges can be generated for that band alone and merged into the
+ * existing consolidated sets.
+ *
+ * The input is expected to be sanitized already (see sanitize()): lengths positive, angles in radians,
+ * minimum values smaller than the maximum values.
+ *
+ * This class is part of the LatticeMatch program.
+ *
+ * To contact the author either use electronic mail: Andreas Grois <andreas.grois@jku.at>
+ * or write to:
+ * Andreas Grois, Institute for Semiconductor and SolidState physics, Johannes Kepler University,
+ * Altenbergerstraße 69, 4040 Linz, AUSTRIA
+ */
+
+#include "matchsolver.h"
+#include "rangeselector.h"
+#include "matrixenumerator.h"
+#include "thetascan.h"
+#include <cmath>
+#include <climits>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+#include <chrono>
+#include <cstring>
+#include <stdint.h>
+
+unsigned int matchsolver::sanitize(double input[9])
+{
+    unsigned int fixed=0;
+    double swapper;
+    unsigned int i;
+    if(input[B1MIN]*input[B2MIN]<0 || input[B1MAX]*input[B2MAX]<0 || input[B1MIN]*input[B1MAX]<0)
+    {
+        fixed|=SANITIZED_B_SIGNS;
+        input[BETAMIN]=180-input[BETAMIN];
+        input[BETAMAX]=180-input[BETAMAX];
+    }
+    if(input[A1]*input[A2]<0)
+    {
+        fixed|=SANITIZED_A_SIGNS;
+        input[ALPHA]=180-input[ALPHA];
+    }
+    for(i=B1MIN;i<=B2MAX;i++)
+    {
+        input[i]=fabs(input[i]);
+    }
+    input[A1]=fabs(input[A1]);
+    input[A2]=fabs(input[A2]);
+
+    input[BETAMIN]=(input[BETAMIN]-360*floor(input[BETAMIN]/360.0))*M_PI/180.0;
+    input[BETAMAX]=(input[BETAMAX]-360*floor(input[BETAMAX]/360.0))*M_PI/180.0;
+    input[ALPHA]=(input[ALPHA]-360*floor(input[ALPHA]/360.0))*M_PI/180.0;
+
+    for(i=0;i<3;i++)
+    {
+        if(input[2*i+3]>input[2*i+1+3])
+        {
+            swapper = input[2*i+3];
+            input[2*i+3] = input[2*i+1+3];
+            input[2*i+1+3] = swapper;
+        }
+    }
+    if(input[BETAMAX]-input[BETAMIN]>M_PI)
+    {
+        fixed|=SANITIZED_WIDE_BETA;
+    }
+    return(fixed);
+}
+
+matchsolver::matchsolver()
+{
+    for(int i=0;i<9;i++)
+    {
+        params[i]=0.0;
+    }
+    loops=1;
+    solved=false;
+    solvetime=0.0;
+    indexlimit=UINT_MAX;
+    minwidth=0.0;
+    strain=0.0;
+    maxdeterminant=0;
+    maxorder=1;
+    asins=0;
+    familiesloaded=false;
+    familiescomplete=false;
+    labelling=false;
+    counting=false;
+    fitting=false;
+}
+
+matchsolver::matchsolver(const double input[9])
+{
+    asins=0;
+    indexlimit=UINT_MAX;
+    minwidth=0.0;
+    strain=0.0;
+    maxdeterminant=0;
+    maxorder=1;
+    solvetime=0.0;
+    familiesloaded=false;
+    labelling=false;
+    counting=false;
+    fitting=false;
+    setparams(input);
+}
+
+void matchsolver::setparams(const double input[9])
+{
+    for(int i=0;i<9;i++)
+    {
+        params[i]=input[i];
+    }
+    //if the substrate is hexagonal, we need to run the whole calculation twice: Once for the lattice vectors given by the user, and once for the angle changed by 60°.
+    //don't judge me by the following line, it's there because I'm too lazy to care about the floating point precision.
+    loops=1;
+    if(params[ALPHA]==60.0*M_PI/180.0 || params[ALPHA]==120.0*M_PI/180.0 || params[ALPHA]==240.0*M_PI/180.0 || params[ALPHA]==300.0*M_PI/180.0)
+    {
+        loops=2;
+        params[ALPHA]=60.0*M_PI/180.0;
+    }
+    //should there be a second run, we need to increase alpha by 60°.
+    hexloops[0].alpha=params[ALPHA];
+    hexloops[1].alpha=params[ALPHA]+M_PI/3.0;
+    solved=false;
+    familiescomplete=false;
+    labels.clear();
+    multiplicity.clear();
+    coincidentorders.clear();
+    commensurateorders.clear();
+    coincidentfits.clear();
+    commensuratefits.clear();
+}
+
+double matchsolver::getparam(paramnames which) const
+{
+    return(params[which]);
+}
+
+int matchsolver::getloops() const
+{
+    return(loops);
+}
+
+double matchsolver::getsolvetime() const
+{
+    return(solvetime);
+}
+
+angleset& matchsolver::getcoincident()
+{
+    return(coincident);
+}
+
+angleset& matchsolver::getcommensurate()
+{
+    return(commensurate);
+}
+
+matchsink::~matchsink()
+{
+}
+
+void matchsolver::setasintable(const asintable *table)
+{
+    asins=table;
+}
+
+void matchsolver::setminwidth(double width)
+{
+    minwidth=width;
+}
+
+void matchsolver::setstrain(double relative)
+{
+    strain=relative;
+}
+
+void matchsolver::setmaxdeterminant(unsigned int limit)
+{
+    maxdeterminant=limit;
+    labels.setmaxdeterminant(limit);
+}
+
+void matchsolver::areacaps(double &b1max, double &b2max) const
+{
+    b1max=params[B1MAX];
+    b2max=params[B2MAX];
+    if(maxdeterminant==0)
+    {
+        return;
+    }
+    //|sin(beta)| is smallest at one end of the window, unless there's a multiple of 180 degrees inside.
+    const double betamin=params[BETAMIN]-2*strain, betamax=params[BETAMAX]+2*strain;
+    if(ceil(betamin/M_PI)<=betamax/M_PI)
+    {
+        return;
+    }
+    const double lowest=fmin(fabs(sin(betamin)),fabs(sin(betamax)));
+    //the largest area a supercell may have, and with the other vector as short as it gets, that's as long as one can be.
+    const double area=maxdeterminant*fabs(params[A1]*params[A2]*sin(params[ALPHA]));
+    b1max=fmax(params[B1MIN],fmin(b1max,area/(params[B2MIN]*(1.0-strain)*lowest)));
+    b2max=fmax(params[B2MIN],fmin(b2max,area/(params[B1MIN]*(1.0-strain)*lowest)));
+}
+
+void matchsolver::setmaxorder(unsigned int order)
+{
+    maxorder = order<1 ? 1 : order;
+}
+
+const std::vector<unsigned int>& matchsolver::getorders(bool commensurate) const
+{
+    return(commensurate ? commensurateorders : coincidentorders);
+}
+
+void matchsolver::setprovenance(bool on)
+{
+    labelling=on;
+}
+
+const provenance& matchsolver::getprovenance() const
+{
+    return(labels);
+}
+
+void matchsolver::setcoverage(bool on)
+{
+    counting=on;
+}
+
+const coverage& matchsolver::getcoverage() const
+{
+    return(multiplicity);
+}
+
+void matchsolver::setbestangles(bool on)
+{
+    fitting=on;
+}
+
+const std::vector<bestangle::fit>& matchsolver::getfits(bool commensurate) const
+{
+    return(commensurate ? commensuratefits : coincidentfits);
+}
+
+void matchsolver::fitresults()
+{
+    if(!fitting)
+    {
+        return;
+    }
+    std::chrono::steady_clock::time_point start=std::chrono::steady_clock::now();
+    bestangle fitter(params,loops);
+    fitter.fitall(coincident.getrangesref(),false,coincidentfits);
+    fitter.fitall(commensurate.getrangesref(),true,commensuratefits);
+    solvetime+=std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+}
+
+//Euclid. std::gcd would need C++17.
+static unsigned int greatestdivisor(unsigned int a, unsigned int b)
+{
+    while(b!=0)
+    {
+        const unsigned int rest=a%b;
+        a=b;
+        b=rest;
+    }
+    return(a);
+}
+
+int matchsolver::outwards(const hexloop &loop) const
+{
+    //asin(i*a*sin(alpha)/b) grows towards smaller b if sin(alpha) is positive, and shrinks if it's negative.
+    //Rounding the value at bmin in that direction, and the value at bmax in the opposite one, makes the ranges larger.
+    return(sin(loop.alpha)>=0 ? 1 : -1);
+}
+
+void matchsolver::strainborders(double &atbmin, double &atbmax, double xatbmax, int dir, bool outer) const
+{
+    if(strain<=0.0)
+    {
+        return;
+    }
+    //both have the sign of sin(alpha). The value at bmin gets further away from 0 with b*(1-strain), the one at
+    //bmax gets closer with b*(1+strain). Both are evaluated where they end up: a bound from the derivative
+    //1/sqrt(1-x^2) grows without limit as x gets close to 1, and made ranges degrees too wide there.
+    if(outer)
+    {
+        atbmin=evalasin(fmax(-1.0,fmin(1.0,sin(atbmin)/(1.0-strain))),-dir);
+    }
+    //for an index that is only there because of the strain, see setlimits(), xatbmax is beyond 1, and this is
+    //the only place b*(1+strain) reaches.
+    atbmax=evalasin(fmax(-1.0,fmin(1.0,xatbmax/(1.0+strain))),dir);
+}
+
+double matchsolver::evalasin(double x, int dir) const
+{
+    if(asins)
+    {
+        return(asins->lookup(x,dir));
+    }
+    return(asin(x));
+}
+
+void matchsolver::setlimits(hexloop &loop, double b1max, double b2max) const
+{
+    //as sin(alpha) can be negative -> fabs
+    //solutions run from -maxn to maxn, and from -maxm to maxm.
+    //a strained film can be that much longer, which can make room for one or two more indices.
+    b1max*=1.0+strain;
+    b2max*=1.0+strain;
+    loop.maxn=fabs(b1max/(params[A1]*sin(loop.alpha)));
+    loop.maxm=fabs(b2max/(params[A1]*sin(loop.alpha)));
+    loop.maxo=fabs(b1max/(params[A2]*sin(loop.alpha)));
+    loop.maxp=fabs(b2max/(params[A2]*sin(loop.alpha)));
+}
+
+unsigned int matchsolver::orderlimit(double bmax, double a, double sine, unsigned int order) const
+{
+    //setlimits(), for entries order times finer.
+    return(bmax*fabs(order*(1.0+strain)/sine)/a);
+}
+
+void matchsolver::addpx(const hexloop &loop, unsigned int from, unsigned int to, double bmin, double bmax, angleset *targets, std::vector<int> *indices, unsigned int firstorder, unsigned int lastorder, bool band) const
+{
+    const double alpha=loop.alpha;
+    //As asin changes sign together with its argument, one has to treat positive and negative n differently
+    //first the special case n=0:
+    if(from==0)
+    {
+        //points, so they don't survive any minimum width.
+        if(minwidth<=0.0)
+        {
+            targets[0].add(alpha,alpha);
+            targets[0].add(alpha - M_PI, alpha - M_PI);
+            if(indices)
+            {
+                indices->insert(indices->end(),2,0);
+            }
+        }
+        from=1;
+    }
+    //now the slightly more difficult case: n>0
+    const int dir=outwards(loop);
+    const double sine=sin(loop.alpha);
+    for(unsigned int i=from;i<=to;i++)
+    {
+        //the same for all denominators.
+        const double atbmin=i*params[A1]*sine/bmin, atbmax=i*params[A1]*sine/bmax;
+        for(unsigned int order=firstorder;order<=lastorder;order++)
+        {
+            //beyond the index limit of this denominator, or the same fraction in lower terms was added with a smaller one already.
+            if(order>1 && (i>orderlimit(bmax,params[A1],sine,order) || greatestdivisor(i,order)!=1))
+            {
+                continue;
+            }
+            angleset &target=targets[order-firstorder];
+            //while factoring out the asin doesn't improve performance much - it's only used twice, it improves readability, as the important thing in the formulas below
+            //are the signs.
+            //the fmax and fmin are there, because maxn was calculated using bmax. With bmin the argument of arcsine can very well be outside its defined range.
+            double asina1b1min=evalasin(fmax(-1.0,fmin(1.0,atbmin/order)),dir);
+            //clamped as well: with a strain, the index limits are for a longer bmax.
+            const double xatbmax=atbmax/order;
+            double asina1b1max=evalasin(fmax(-1.0,fmin(1.0,xatbmax)),-dir);
+            strainborders(asina1b1min,asina1b1max,xatbmax,-dir,!band);
+            //all four ranges of this index are that wide, overlaps with them can only be narrower.
+            if(fabs(asina1b1min-asina1b1max)<minwidth)
+            {
+                continue;
+            }
+            //we need to consider that sin(alpha) can be negative. In that case the sign of the asin will change as well.
+            if(asina1b1min>=0)
+            {
+                target.add(
+                            alpha - asina1b1min,
+                            alpha - asina1b1max
+                            );
+                target.add(
+                            alpha - M_PI + asina1b1max,
+                            alpha - M_PI + asina1b1min
+                            );
+                //and the most difficult case: n<0
+                //here the arcsin is negative. as i is positive, I'll just change the sign in front of the arcsin.
+                target.add(
+                            alpha + asina1b1max,
+                            alpha + asina1b1min
+                            );
+                target.add(
+                            alpha - M_PI - asina1b1min,
+                            alpha - M_PI - asina1b1max
+                            );
+            }
+            else
+            {
+                //just as above, but with upper and lower limits switched
+                target.add(
+                            alpha - asina1b1max,
+                            alpha - asina1b1min
+                            );
+                target.add(
+                            alpha - M_PI + asina1b1min,
+                            alpha - M_PI + asina1b1max
+                            );
+                //n<0
+                target.add(
+                            alpha + asina1b1min,
+                            alpha + asina1b1max
+                            );
+                target.add(
+                            alpha - M_PI - asina1b1max,
+                            alpha - M_PI - asina1b1min
+                            );
+            }
+            if(indices)
+            {
+                //the first two ranges are those of index +i, the other two those of -i.
+                const int index=i;
+                indices->insert(indices->end(),{index,index,-index,-index});
+            }
+        }
+    }
+}
+
+void matchsolver::addqx(const hexloop &loop, unsigned int from, unsigned int to, double bmin, double bmax, angleset *targets, std::vector<int> *indices, unsigned int firstorder, unsigned int lastorder, bool band) const
+{
+    //a strained film can have beta off by twice the strain.
+    const double betamin=params[BETAMIN]-2*strain, betamax=params[BETAMAX]+2*strain;
+    const double alpha=loop.alpha;
+    //same nonsense as for px
+    //first the easy part: m=0;
+    if(from==0)
+    {
+        if(betamax-betamin>=minwidth)
+        {
+            targets[0].add(
+                        alpha - betamax,
+                        alpha - betamin
+                        );
+            targets[0].add(
+                        alpha - betamax - M_PI,
+                        alpha - betamin - M_PI
+                        );
+            if(indices)
+            {
+                indices->insert(indices->end(),2,0);
+            }
+        }
+        from=1;
+    }
+    //now the slightly more difficult case: m>0;
+    const int dir=outwards(loop);
+    const double sine=sin(loop.alpha);
+    for(unsigned int i=from;i<=to;i++)
+    {
+        //the same for all denominators.
+        const double atbmin=i*params[A1]*sine/bmin, atbmax=i*params[A1]*sine/bmax;
+        for(unsigned int order=firstorder;order<=lastorder;order++)
+        {
+            //beyond the index limit of this denominator, or the same fraction in lower terms was added with a smaller one already.
+            if(order>1 && (i>orderlimit(bmax,params[A1],sine,order) || greatestdivisor(i,order)!=1))
+            {
+                continue;
+            }
+            angleset &target=targets[order-firstorder];
+            //also here, the asin values are factored out for improved readability.
+            double asina1b2min=evalasin(fmax(fmin(atbmin/order,1.0),-1.0),dir);
+            //clamped as well: with a strain, the index limits are for a longer bmax.
+            const double xatbmax=atbmax/order;
+            double asina1b2max=evalasin(fmax(-1.0,fmin(1.0,xatbmax)),-dir);
+            strainborders(asina1b2min,asina1b2max,xatbmax,-dir,!band);
+            //the beta range adds to the width.
+            if(fabs(asina1b2min-asina1b2max)+betamax-betamin<minwidth)
+            {
+                continue;
+            }
+            //same here: keep in mind that sin(alpha) can be negative:
+            if(asina1b2min>=0)
+            {
+                target.add(
+                            alpha - betamax - asina1b2min,
+                            alpha - betamin - asina1b2max
+                            );
+                target.add(
+                            alpha - betamax - M_PI + asina1b2max,
+                            alpha - betamin - M_PI + asina1b2min
+                            );
+                //and last, but not leasst, the most difficult, m<0 - here the arcsin is negative;
+                //as i is positive, I'll just change the sign in front of the arcsin.
+                target.add(
+                            alpha - betamax + asina1b2max,
+                            alpha - betamin + asina1b2min
+                            );
+                target.add(
+                            alpha - betamax - M_PI - asina1b2min,
+                            alpha - betamin - M_PI - asina1b2max
+                            );
+            }
+            else
+            {
+                target.add(
+                            alpha - betamax - asina1b2max,
+                            alpha - betamin - asina1b2min
+                            );
+                target.add(
+                            alpha - betamax - M_PI + asina1b2min,
+                            alpha - betamin - M_PI + asina1b2max
+                            );
+                //m<0
+                target.add(
+                            alpha - betamax + asina1b2min,
+                            alpha - betamin + asina1b2max
+                            );
+                target.add(
+                            alpha - betamax - M_PI - asina1b2max,
+                            alpha - betamin - M_PI - asina1b2min
+                            );
+            }
+            if(indices)
+            {
+                const int index=i;
+                indices->insert(indices->end(),{index,index,-index,-index});
+            }
+        }
+    }
+}
+
+void matchsolver::addqy(const hexloop &loop, unsigned int from, unsigned int to, double bmin, double bmax, angleset *targets, std::vector<int> *indices, unsigned int firstorder, unsigned int lastorder, bool band) const
+{
+    //As previously we need to consider the "sign" of o and sin(alpha)
+    //first: o=0
+    if(from==0)
+    {
+        if(minwidth<=0.0)
+        {
+            targets[0].add(0.0,0.0);
+            targets[0].add(M_PI,M_PI);
+            if(indices)
+            {
+                indices->insert(indices->end(),2,0);
+            }
+        }
+        from=1;
+    }
+    const int dir=outwards(loop);
+    const double sine=sin(loop.alpha);
+    for(unsigned int i=from;i<=to;i++)
+    {
+        //the same for all denominators.
+        const double atbmin=i*params[A2]*sine/bmin, atbmax=i*params[A2]*sine/bmax;
+        for(unsigned int order=firstorder;order<=lastorder;order++)
+        {
+            //beyond the index limit of this denominator, or the same fraction in lower terms was added with a smaller one already.
+            if(order>1 && (i>orderlimit(bmax,params[A2],sine,order) || greatestdivisor(i,order)!=1))
+            {
+                continue;
+            }
+            angleset &target=targets[order-firstorder];
+            //also here: factor out the asin for improved readability.
+            double asina2b1min = evalasin(fmax(-1.0,fmin(1.0,atbmin/order)),dir);
+            //clamped as well: with a strain, the index limits are for a longer bmax.
+            const double xatbmax=atbmax/order;
+            double asina2b1max=evalasin(fmax(-1.0,fmin(1.0,xatbmax)),-dir);
+            strainborders(asina2b1min,asina2b1max,xatbmax,-dir,!band);
+            if(fabs(asina2b1min-asina2b1max)<minwidth)
+            {
+                continue;
+            }
+            //is sin(alpha)>0?
+            if(asina2b1min>=0)
+            {
+                //case: o>0
+                target.add(
+                            asina2b1max,
+                            asina2b1min
+                            );
+                target.add(
+                            M_PI - asina2b1min,
+                            M_PI - asina2b1max
+                            );
+                //case: o<0
+                target.add(
+                            -asina2b1min,
+                            -asina2b1max
+                            );
+                target.add(
+                            M_PI + asina2b1max,
+                            M_PI + asina2b1min
+                            );
+            }
+            else
+            {
+                //case: o>0
+                target.add(
+                            asina2b1min,
+                            asina2b1max
+                            );
+                target.add(
+                            M_PI - asina2b1max,
+                            M_PI - asina2b1min
+                            );
+                //case: o<0
+                target.add(
+                            -asina2b1max,
+                            -asina2b1min
+                            );
+                target.add(
+                            M_PI + asina2b1min,
+                            M_PI + asina2b1max
+                            );
+            }
+            if(indices)
+            {
+                const int index=i;
+                indices->insert(indices->end(),{index,index,-index,-index});
+            }
+        }
+    }
+    //that was too easy. Probably it's buggy as hell...
+}
+
+void matchsolver::addpy(const hexloop &loop, unsigned int from, unsigned int to, double bmin, double bmax, angleset *targets, std::vector<int> *indices, unsigned int firstorder, unsigned int lastorder, bool band) const
+{
+    //a strained film can have beta off by twice the strain.
+    const double betamin=params[BETAMIN]-2*strain, betamax=params[BETAMAX]+2*strain;
+    if(from==0)
+    {
+        if(betamax-betamin>=minwidth)
+        {
+            targets[0].add(
+                        -betamax,
+                        -betamin
+                        );
+            targets[0].add(
+                        M_PI - betamax,
+                        M_PI - betamin
+                        );
+            if(indices)
+            {
+                indices->insert(indices->end(),2,0);
+            }
+        }
+        from=1;
+    }
+    const int dir=outwards(loop);
+    const double sine=sin(loop.alpha);
+    for(unsigned int i=from;i<=to;i++)
+    {
+        //the same for all denominators.
+        const double atbmin=i*params[A2]*sine/bmin, atbmax=i*params[A2]*sine/bmax;
+        for(unsigned int order=firstorder;order<=lastorder;order++)
+        {
+            //beyond the index limit of this denominator, or the same fraction in lower terms was added with a smaller one already.
+            if(order>1 && (i>orderlimit(bmax,params[A2],sine,order) || greatestdivisor(i,order)!=1))
+            {
+                continue;
+            }
+            angleset &target=targets[order-firstorder];
+            //and again: readability
+            double asina2b2min = evalasin(fmax(-1.0,fmin(1.0,atbmin/order)),dir);
+            //clamped as well: with a strain, the index limits are for a longer bmax.
+            const double xatbmax=atbmax/order;
+            double asina2b2max=evalasin(fmax(-1.0,fmin(1.0,xatbmax)),-dir);
+            strainborders(asina2b2min,asina2b2max,xatbmax,-dir,!band);
+            if(fabs(asina2b2min-asina2b2max)+betamax-betamin<minwidth)
+            {
+                continue;
+            }
+            if(asina2b2min>=0)
+            {
+                //case: p>0
+                target.add(
+                            asina2b2max - betamax,
+                            asina2b2min - betamin
+                            );
+                target.add(
+                            M_PI - asina2b2min - betamax,
+                            M_PI - asina2b2max - betamin
+                            );
+                //case: p<0
+                target.add(
+                            -asina2b2min - betamax,
+                            -asina2b2max - betamin
+                            );
+                target.add(
+                            M_PI + asina2b2max - betamax,
+                            M_PI + asina2b2min - betamin
+                            );
+            }
+            else
+            {
+                //ok, here the asin is of opposite sign!
+                //case p>0
+                target.add(
+                            asina2b2min - betamax,
+                            asina2b2max - betamin
+                            );
+                target.add(
+                            M_PI - asina2b2max - betamax,
+                            M_PI - asina2b2min - betamin
+                            );
+                //case: p<0
+                target.add(
+                            -asina2b2max - betamax,
+                            -asina2b2min - betamin
+                            );
+                target.add(
+                            M_PI + asina2b2min - betamax,
+                            M_PI + asina2b2max - betamin
+                            );
+            }
+            if(indices)
+            {
+                const int index=i;
+                indices->insert(indices->end(),{index,index,-index,-index});
+            }
+        }
+    }
+    //99 bottles of bugs on the wall, 99 bottles of bugs. You get one down and fix it up, 99 bottles of bugs...
+    //100 bottles of bugs on the wall, 100 bottles of bugs....
+}
+
+unsigned int matchsolver::capped(unsigned int maximum) const
+{
+    return(maximum<indexlimit ? maximum : indexlimit);
+}
+
+void matchsolver::generate(hexloop &loop)
+{
+    double b1max, b2max;
+    areacaps(b1max,b2max);
+    setlimits(loop,b1max,b2max);
+    //the loaded families are complete, they can't stand in for a limited solve. And they have no indices, which
+    //provenance, the determinant limit and the coverage need.
+    const bool indexed=(labelling || maxdeterminant>0 || counting);
+    bool useloaded=(familiesloaded && indexlimit==UINT_MAX && !indexed && strain==0.0 && loadedkey==currentkey());
+    std::vector<int> *pxindices=0, *qxindices=0, *qyindices=0, *pyindices=0;
+    if(indexed)
+    {
+        loop.pxindices.clear();
+        loop.qxindices.clear();
+        loop.qyindices.clear();
+        loop.pyindices.clear();
+        pxindices=&loop.pxindices;
+        qxindices=&loop.qxindices;
+        qyindices=&loop.qyindices;
+        pyindices=&loop.pyindices;
+    }
+    //strained or capped families aren't what the key says they are, they don't go into a file.
+    familiescomplete=(indexlimit==UINT_MAX && strain==0.0 && maxdeterminant==0);
+    //Due to the ambiguity of asin, two solutions exist for each value of n and m
+    //This means, that (2*maxn+1)*2 solutions exist, the same for m.
+    loop.qxranges.clear();
+    loop.qxranges.reserve(4*capped(loop.maxm)+2);
+    loop.pyranges.clear();
+    loop.pyranges.reserve(4*capped(loop.maxp)+2);
+    if(useloaded)
+    {
+        loop.pxranges=loop.pxloaded;
+        loop.qyranges=loop.qyloaded;
+    }
+    else
+    {
+        loop.pxranges.clear();
+        loop.pxranges.reserve(4*capped(loop.maxn)+2); //reserve memory, so adding stuff is faster...
+        loop.qyranges.clear();
+        loop.qyranges.reserve(4*capped(loop.maxo)+2);
+        addpx(loop,0,capped(loop.maxn),params[B1MIN],b1max,&loop.pxranges,pxindices);
+        addqy(loop,0,capped(loop.maxo),params[B1MIN],b1max,&loop.qyranges,qyindices);
+    }
+    addqx(loop,0,capped(loop.maxm),params[B2MIN],b2max,&loop.qxranges,qxindices);
+    addpy(loop,0,capped(loop.maxp),params[B2MIN],b2max,&loop.pyranges,pyindices);
+}
+
+bool matchsolver::familykey::operator==(const familykey &other) const
+{
+    for(int i=0;i<7;i++)
+    {
+        if(values[i]!=other.values[i])
+        {
+            return(false);
+        }
+    }
+    return(true);
+}
+
+matchsolver::familykey matchsolver::currentkey() const
+{
+    familykey key={{params[A1],params[A2],params[ALPHA],params[B1MIN],params[B1MAX],minwidth,asins ? 1.0 : 0.0}};
+    return(key);
+}
+
+//The file: "LATFAM01", uint32 version (1), uint32 number of loops, the familykey (7 doubles), and then for each
+//loop px and qy as angleset::save() writes them. Byte order of the machine, it's a cache, not an exchange format.
+bool matchsolver::savefamilies(const char *filename)
+{
+    if(!familiescomplete)
+    {
+        return(false);
+    }
+    FILE *file=fopen(filename,"wb");
+    if(!file)
+    {
+        return(false);
+    }
+    uint32_t header[2]={1,static_cast<uint32_t>(loops)};
+    familykey key=currentkey();
+    bool ok=(fwrite("LATFAM01",8,1,file)==1 && fwrite(header,sizeof(header),1,file)==1 && fwrite(key.values,sizeof(key.values),1,file)==1);
+    for(int hexcounter=0;ok && hexcounter<loops;++hexcounter)
+    {
+        ok=hexloops[hexcounter].pxranges.save(file) && hexloops[hexcounter].qyranges.save(file);
+    }
+    return(fclose(file)==0 && ok);
+}
+
+bool matchsolver::loadfamilies(const char *filename)
+{
+    familiesloaded=false;
+    FILE *file=fopen(filename,"rb");
+    if(!file)
+    {
+        return(false);
+    }
+    char magic[8];
+    uint32_t header[2];
+    bool ok=(fread(magic,8,1,file)==1 && memcmp(magic,"LATFAM01",8)==0 && fread(header,sizeof(header),1,file)==1
+             && header[0]==1 && header[1]>=1 && header[1]<=2 && fread(loadedkey.values,sizeof(loadedkey.values),1,file)==1);
+    for(unsigned int hexcounter=0;ok && hexcounter<header[1];++hexcounter)
+    {
+        ok=hexloops[hexcounter].pxloaded.load(file) && hexloops[hexcounter].qyloaded.load(file);
+    }
+    fclose(file);
+    familiesloaded=ok;
+    return(ok);
+}
+
+void matchsolver::solve()
+{
+    indexlimit=UINT_MAX;
+    solvelimited();
+    if(maxorder>1)
+    {
+        solveorders();
+    }
+    fitresults();
+}
+
+void matchsolver::solveorders()
+{
+    std::chrono::steady_clock::time_point start=std::chrono::steady_clock::now();
+    //the families get fractions added, they are no longer what a file of px and qy would say.
+    familiescomplete=false;
+    labels.clear();
+    double b1max, b2max;
+    areacaps(b1max,b2max);
+    //every index is visited once for all denominators, which share what doesn't depend on them. So the new
+    //ranges of all orders are generated first, one set per order, loop and family.
+    std::vector<angleset> newpx[2], newqx[2], newqy[2], newpy[2];
+    for(int hexcounter=0;hexcounter<loops;++hexcounter)
+    {
+        const hexloop &loop = hexloops[hexcounter];
+        const double sine=sin(loop.alpha);
+        newpx[hexcounter].resize(maxorder-1);
+        newqx[hexcounter].resize(maxorder-1);
+        newqy[hexcounter].resize(maxorder-1);
+        newpy[hexcounter].resize(maxorder-1);
+        for(unsigned int order=2;order<=maxorder;order++)
+        {
+            newpx[hexcounter][order-2].reserve(4*orderlimit(b1max,params[A1],sine,order));
+            newqx[hexcounter][order-2].reserve(4*orderlimit(b2max,params[A1],sine,order));
+            newqy[hexcounter][order-2].reserve(4*orderlimit(b1max,params[A2],sine,order));
+            newpy[hexcounter][order-2].reserve(4*orderlimit(b2max,params[A2],sine,order));
+        }
+        addpx(loop,1,orderlimit(b1max,params[A1],sine,maxorder),params[B1MIN],b1max,&newpx[hexcounter][0],0,2,maxorder);
+        addqx(loop,1,orderlimit(b2max,params[A1],sine,maxorder),params[B2MIN],b2max,&newqx[hexcounter][0],0,2,maxorder);
+        addqy(loop,1,orderlimit(b1max,params[A2],sine,maxorder),params[B1MIN],b1max,&newqy[hexcounter][0],0,2,maxorder);
+        addpy(loop,1,orderlimit(b2max,params[A2],sine,maxorder),params[B2MIN],b2max,&newpy[hexcounter][0],0,2,maxorder);
+    }
+    //the results after each order. Each one only grows from the last, so they are kept to tag the final ranges.
+    std::vector<std::vector<anglerange> > coincidents(1,coincident.getrangesref()), commensurates(1,commensurate.getrangesref());
+    for(unsigned int order=2;order<=maxorder;order++)
+    {
+        for(int hexcounter=0;hexcounter<loops;++hexcounter)
+        {
+            hexloop &loop = hexloops[hexcounter];
+            angleset &px=newpx[hexcounter][order-2], &qx=newqx[hexcounter][order-2];
+            angleset &qy=newqy[hexcounter][order-2], &py=newpy[hexcounter][order-2];
+            if(minwidth>0.0)
+            {
+                //see merge(): only the grown families tell which ranges are wide enough.
+                loop.pxranges.add(px);
+                loop.qxranges.add(qx);
+                loop.qyranges.add(qy);
+                loop.pyranges.add(py);
+            }
+            else
+            {
+                merge(loop,px,qx,qy,py);
+            }
+        }
+        if(minwidth>0.0)
+        {
+            coincident.clear();
+            commensurate.clear();
+            for(int hexcounter=0;hexcounter<loops;++hexcounter)
+            {
+                intersect(hexloops[hexcounter]);
+            }
+        }
+        coincident.sort();
+        commensurate.sort();
+        coincidents.push_back(coincident.getrangesref());
+        commensurates.push_back(commensurate.getrangesref());
+    }
+    tagorders(coincident.getrangesref(),coincidents,coincidentorders);
+    tagorders(commensurate.getrangesref(),commensurates,commensurateorders);
+    solvetime+=std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+}
+
+void matchsolver::tagorders(const std::vector<anglerange> &results, const std::vector<std::vector<anglerange> > &snapshots, std::vector<unsigned int> &orders)
+{
+    orders.assign(results.size(),0);
+    std::vector<double> lowers;
+    lowers.reserve(results.size());
+    for(std::vector<anglerange>::const_iterator i=results.begin();i!=results.end();++i)
+    {
+        lowers.push_back(i->getlower().getval());
+    }
+    for(size_t k=0;k<snapshots.size();k++)
+    {
+        for(std::vector<anglerange>::const_iterator i=snapshots[k].begin();i!=snapshots[k].end();++i)
+        {
+            //the last result that starts at or before this range, unless the range is in the part of the last
+            //result that goes on past 2pi. A full circle is the only result there is.
+            const angleclass lower=i->getlower();
+            size_t found=std::upper_bound(lowers.begin(),lowers.end(),lower.getval())-lowers.begin();
+            found = (found==0 || !results[found-1].isinside(lower)) ? results.size()-1 : found-1;
+            if(found<results.size() && orders[found]==0)
+            {
+                orders[found]=k+1;
+            }
+        }
+    }
+}
+
+void matchsolver::intersect(hexloop &loop)
+{
+    //Calculate the overlap between px and qx. Into the sets of the loop, which keep their storage from the last solve.
+    loop.pxranges.overlap(loop.qxranges,loop.xoverlaps);
+    //ok, same thing for qy, py:
+    loop.pyranges.overlap(loop.qyranges,loop.yoverlaps);
+    if(minwidth>0.0)
+    {
+        loop.xoverlaps.prune(minwidth);
+        loop.yoverlaps.prune(minwidth);
+    }
+
+    coincident.add(loop.xoverlaps);
+    coincident.add(loop.yoverlaps);
+
+    //to be a commensurate match, an angle has to be in both, x- and yoverlaps
+    loop.xoverlaps.overlap(loop.yoverlaps,loop.both);
+    if(minwidth>0.0)
+    {
+        loop.both.prune(minwidth);
+    }
+    commensurate.add(loop.both);
+}
+
+void matchsolver::solvelimited()
+{
+    std::chrono::steady_clock::time_point start=std::chrono::steady_clock::now();
+    coincident.clear();
+    commensurate.clear();
+    coincidentorders.clear();
+    commensurateorders.clear();
+    coincidentfits.clear();
+    commensuratefits.clear();
+    labels.clear();
+    multiplicity.clear();
+    //a limited solve is followed by refine(), which has no indices to add.
+    const bool labelled=(labelling && indexlimit==UINT_MAX);
+    //the determinant needs all four indices of a match, only the pieces of the labels have them.
+    const bool determinants=(maxdeterminant>0 && indexlimit==UINT_MAX);
+    const bool counted=(counting && indexlimit==UINT_MAX);
+    for(int hexcounter=0;hexcounter<loops;++hexcounter)
+    {
+        hexloop &loop = hexloops[hexcounter];
+        generate(loop);
+        if(counted)
+        {
+            multiplicity.addloop(hexcounter,loop.pxranges.getrawref(),loop.pxindices,loop.qxranges.getrawref(),loop.qxindices,
+                                 loop.qyranges.getrawref(),loop.qyindices,loop.pyranges.getrawref(),loop.pyindices);
+        }
+        if(labelled || determinants)
+        {
+            //before the overlaps consolidate the families.
+            labels.addloop(hexcounter,loop.pxranges.getrawref(),loop.pxindices,loop.qxranges.getrawref(),loop.qxindices,
+                           loop.qyranges.getrawref(),loop.qyindices,loop.pyranges.getrawref(),loop.pyindices);
+        }
+        intersect(loop);
+    }
+    if(determinants)
+    {
+        //only what the matrices with small enough determinants cover. They are in pieces that ignore the
+        //minimum width, so it is cut out of what it gave.
+        allowed.clear();
+        labels.addcommensurate(allowed);
+        allowed.overlap(commensurate,restricted);
+        commensurate=restricted;
+        if(minwidth>0.0)
+        {
+            commensurate.prune(minwidth);
+        }
+    }
+    coincident.sort();
+    commensurate.sort();
+    if(labelled)
+    {
+        labels.assign(coincident,commensurate);
+    }
+    else if(determinants)
+    {
+        labels.clear();
+    }
+    if(counted)
+    {
+        multiplicity.finish();
+    }
+    else if(determinants)
+    {
+        multiplicity.clear();
+    }
+    solved=true;
+    solvetime=std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+}
+
+//border k of the circle cut into sectors. The last border is exactly 2pi, so the sectors close the circle without a gap.
+bool matchsolver::sweepangle::operator<(const sweepangle &other) const
+{
+    return(turn<other.turn || (turn==other.turn && raw<other.raw));
+}
+
+bool matchsolver::sweepangle::operator<=(const sweepangle &other) const
+{
+    return(!(other<*this));
+}
+
+matchsolver::sweepangle matchsolver::sectorborder(unsigned int k, unsigned int sectors, double origin)
+{
+    sweepangle border;
+    if(k==sectors)
+    {
+        border.turn=1;
+        border.raw=origin;
+        return(border);
+    }
+    border.raw=angleclass(origin+2.0*M_PI*k/sectors).getval();
+    border.turn = border.raw<origin ? 1 : 0;
+    return(border);
+}
+
+void matchsolver::generateall()
+{
+    coincident.clear();
+    commensurate.clear();
+    coincidentorders.clear();
+    commensurateorders.clear();
+    coincidentfits.clear();
+    commensuratefits.clear();
+    labels.clear();
+    multiplicity.clear();
+    indexlimit=UINT_MAX;
+    //generating the families is cheap, it's their overlaps that cost. Those are done sector by sector.
+    for(int hexcounter=0;hexcounter<loops;++hexcounter)
+    {
+        generate(hexloops[hexcounter]);
+        hexloops[hexcounter].xoverlaps.clear();
+        hexloops[hexcounter].yoverlaps.clear();
+    }
+}
+
+void matchsolver::sectoroverlaps(hexloop &loop, const anglerange &sector, angleset &x, angleset &y)
+{
+    angleset px=loop.pxranges.clip(sector);
+    angleset qx=loop.qxranges.clip(sector);
+    x=px.overlap(qx);
+    angleset qy=loop.qyranges.clip(sector);
+    angleset py=loop.pyranges.clip(sector);
+    y=py.overlap(qy);
+    if(minwidth>0.0)
+    {
+        x.prune(minwidth,sector);
+        y.prune(minwidth,sector);
+    }
+}
+
+angleset matchsolver::sectorboth(angleset &x, angleset &y, const anglerange &sector) const
+{
+    angleset both=x.overlap(y);
+    if(minwidth>0.0)
+    {
+        both.prune(minwidth,sector);
+    }
+    return(both);
+}
+
+void matchsolver::solve(unsigned int sectors, matchsink &sink)
+{
+    solvesectors(sectors,&sink,true);
+}
+
+void matchsolver::solvesectors(unsigned int sectors, matchsink *sink, bool keep)
+{
+    startsweep(sectors,0.0,sink,keep);
+    while(sweepstep());
+}
+
+void matchsolver::startsweep(unsigned int sectors, double origin, matchsink *sink, bool keep)
+{
+    std::chrono::steady_clock::time_point start=std::chrono::steady_clock::now();
+    generateall();
+    solved=false;
+    //a single sector would be [0:2pi], which anglerange can't tell apart from the point 0.
+    sweep.sectors = sectors<2 ? 2 : sectors;
+    sweep.next=0;
+    sweep.sink=sink;
+    sweep.keep=keep;
+    for(int set=0;set<2;set++)
+    {
+        streamstate &state=sweep.states[set];
+        state.commensurate=(set==1);
+        state.origin=angleclass(origin).getval();
+        state.target = keep ? (set==1 ? &commensurate : &coincident) : 0;
+        state.sink=sink;
+        state.count=0;
+        state.carry=false;
+        state.head=false;
+    }
+    solvetime=std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+}
+
+bool matchsolver::sweepstep()
+{
+    if(sweep.next>sweep.sectors)
+    {
+        return(false);
+    }
+    std::chrono::steady_clock::time_point start=std::chrono::steady_clock::now();
+    if(sweep.next<sweep.sectors)
+    {
+        sweepangle sectorlower=sectorborder(sweep.next,sweep.sectors,sweep.states[0].origin);
+        sweepangle sectorupper=sectorborder(sweep.next+1,sweep.sectors,sweep.states[0].origin);
+        anglerange sector(sectorlower.raw,sectorupper.raw);
+        angleset sectorsets[2];
+        for(int hexcounter=0;hexcounter<loops;++hexcounter)
+        {
+            hexloop &loop = hexloops[hexcounter];
+            angleset x, y;
+            sectoroverlaps(loop,sector,x,y);
+            sectorsets[0].add(x);
+            sectorsets[0].add(y);
+            sectorsets[1].add(sectorboth(x,y,sector));
+            if(sweep.keep)
+            {
+                //for extend()
+                loop.xoverlaps.add(x);
+                loop.yoverlaps.add(y);
+            }
+        }
+        for(int set=0;set<2;set++)
+        {
+            streamsector(sweep.states[set],sectorsets[set],sectorlower,sectorupper);
+        }
+    }
+    else
+    {
+        for(int set=0;set<2;set++)
+        {
+            streamfinish(sweep.states[set]);
+        }
+        coincident.sort();
+        commensurate.sort();
+        solved=sweep.keep;
+    }
+    sweep.next++;
+    if(sweep.sink)
+    {
+        sweep.sink->writesectordone();
+    }
+    solvetime+=std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+    return(true);
+}
+
+void matchsolver::solvetop(unsigned int k, const rangescore &score)
+{
+    std::chrono::steady_clock::time_point start=std::chrono::steady_clock::now();
+    rangeselector selector(k,score);
+    solvesectors(querysectors,&selector,false);
+    for(int set=0;set<2;set++)
+    {
+        std::vector<rangeselector::scoredrange> best=selector.getbest(set==1);
+        angleset &target = set==1 ? commensurate : coincident;
+        for(std::vector<rangeselector::scoredrange>::const_iterator i=best.begin();i!=best.end();++i)
+        {
+            target.add(i->range);
+        }
+        target.sort();
+    }
+    solvetime=std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+    fitresults();
+}
+
+unsigned long matchsolver::solveenumerated()
+{
+    std::chrono::steady_clock::time_point start=std::chrono::steady_clock::now();
+    coincident.clear();
+    commensurate.clear();
+    coincidentorders.clear();
+    commensurateorders.clear();
+    coincidentfits.clear();
+    commensuratefits.clear();
+    labels.clear();
+    multiplicity.clear();
+    solved=false;
+    std::vector<matrixenumerator::match> matches;
+    matrixenumerator(params).enumerate(matches);
+    //sorted by theta, so several matrices at one angle are next to each other, and the points are in order.
+    for(size_t i=0;i<matches.size();i++)
+    {
+        if(i==0 || matches[i].theta!=matches[i-1].theta)
+        {
+            commensurate.append(anglerange(matches[i].theta,matches[i].theta));
+        }
+    }
+    solvetime=std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+    return(matches.size());
+}
+
+//the runs of grid points with the given flag, as ranges. One that goes on through 0 is appended last, as it
+//starts last.
+static void scanruns(const std::vector<unsigned char> &flags, unsigned char flag, angleset &target)
+{
+    const size_t points=flags.size();
+    size_t first=0;
+    while(first<points && (flags[first]&flag))
+    {
+        first++;
+    }
+    if(first==points)
+    {
+        if(points>0)
+        {
+            anglerange circle;
+            circle.setcircle(true);
+            target.append(circle);
+        }
+        return;
+    }
+    //first doesn't match, so a run that covers 0 either starts there, or comes from the end of the grid.
+    const double step=2*M_PI/points;
+    if(first>0 && !(flags[points-1]&flag))
+    {
+        target.append(anglerange(0.0,(first-1)*step));
+    }
+    for(size_t k=first+1;k<points;k++)
+    {
+        if(!(flags[k]&flag))
+        {
+            continue;
+        }
+        size_t end=k;
+        while(flags[(end+1)%points]&flag)
+        {
+            end=(end+1)%points;
+        }
+        target.append(anglerange(k*step,end*step));
+        if(end<k)
+        {
+            break;
+        }
+        k=end;
+    }
+}
+
+void matchsolver::solvescan(unsigned int points)
+{
+    std::chrono::steady_clock::time_point start=std::chrono::steady_clock::now();
+    coincident.clear();
+    commensurate.clear();
+    coincidentorders.clear();
+    commensurateorders.clear();
+    coincidentfits.clear();
+    commensuratefits.clear();
+    labels.clear();
+    multiplicity.clear();
+    solved=false;
+    std::vector<unsigned char> flags;
+    thetascan(params,loops).scan(points,flags);
+    scanruns(flags,thetascan::SCAN_COINCIDENT,coincident);
+    scanruns(flags,thetascan::SCAN_COMMENSURATE,commensurate);
+    solvetime=std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+}
+
+bool matchsolver::findcommensurate()
+{
+    if(minwidth>0.0)
+    {
+        //a narrow overlap in one sector may be part of a wide range, only the sector-crossing bookkeeping can tell.
+        return(countsectors(true)>0);
+    }
+    std::chrono::steady_clock::time_point start=std::chrono::steady_clock::now();
+    generateall();
+    solved=false; //the overlaps are left half done
+    bool found=false;
+    for(unsigned int k=0;k<querysectors && !found;k++)
+    {
+        anglerange sector(sectorborder(k,querysectors,0.0).raw,sectorborder(k+1,querysectors,0.0).raw);
+        for(int hexcounter=0;hexcounter<loops && !found;++hexcounter)
+        {
+            angleset x, y;
+            sectoroverlaps(hexloops[hexcounter],sector,x,y);
+            //no need to know where exactly x and y overlap, just if they do.
+            found=x.intersects(y);
+        }
+    }
+    solvetime=std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+    return(found);
+}
+
+unsigned long matchsolver::countcommensurate()
+{
+    return(countsectors(false));
+}
+
+unsigned long matchsolver::countsectors(bool stopatfirst)
+{
+    std::chrono::steady_clock::time_point start=std::chrono::steady_clock::now();
+    generateall();
+    solved=false;
+    //the same bookkeeping as when streaming, so ranges going across sector borders are counted once. But nothing is kept.
+    streamstate state;
+    state.commensurate=true;
+    state.origin=0.0;
+    state.target=0;
+    state.sink=0;
+    state.count=0;
+    state.carry=false;
+    state.head=false;
+    for(unsigned int k=0;k<querysectors && !(stopatfirst && state.count>0);k++)
+    {
+        sweepangle sectorlower=sectorborder(k,querysectors,0.0);
+        sweepangle sectorupper=sectorborder(k+1,querysectors,0.0);
+        anglerange sector(sectorlower.raw,sectorupper.raw);
+        angleset sectorset;
+        for(int hexcounter=0;hexcounter<loops;++hexcounter)
+        {
+            angleset x, y;
+            sectoroverlaps(hexloops[hexcounter],sector,x,y);
+            if(!x.isempty() && !y.isempty())
+            {
+                sectorset.add(sectorboth(x,y,sector));
+            }
+        }
+        streamsector(state,sectorset,sectorlower,sectorupper);
+    }
+    streamfinish(state);
+    solvetime=std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+    return(state.count);
+}
+
+void matchsolver::streamsector(streamstate &state, angleset &sectorset, const sweepangle &sectorlower, const sweepangle &sectorupper)
+{
+    //unwrap: angles below origin belong to the end of the sweep, and in the last sector the upper border
+    //origin+2pi is stored as origin.
+    const std::vector<anglerange> &storage=sectorset.getrangesref();
+    std::vector<std::pair<sweepangle,sweepangle> > pieces;
+    pieces.reserve(storage.size());
+    for(std::vector<anglerange>::const_iterator i=storage.begin();i!=storage.end();++i)
+    {
+        sweepangle lower, upper;
+        lower.raw=i->getlower().getval();
+        upper.raw=i->getupper().getval();
+        lower.turn = lower.raw<state.origin ? 1 : 0;
+        upper.turn = upper.raw<state.origin ? 1 : 0;
+        if(lower<sectorlower)
+        {
+            lower.turn++;
+        }
+        if(upper<sectorlower)
+        {
+            upper.turn++;
+        }
+        pieces.push_back(std::make_pair(lower,upper));
+    }
+    std::sort(pieces.begin(),pieces.end());
+    for(std::vector<std::pair<sweepangle,sweepangle> >::const_iterator i=pieces.begin();i!=pieces.end();++i)
+    {
+        //only the first piece can continue the carry from the sector before, the pieces are disjoint otherwise.
+        if(state.carry && i->first<=state.carryupper)
+        {
+            if(state.carryupper<i->second)
+            {
+                state.carryupper=i->second;
+            }
+            continue;
+        }
+        streamcarry(state);
+        state.carry=true;
+        state.carrylower=i->first;
+        state.carryupper=i->second;
+    }
+    if(state.carry && state.carryupper<sectorupper)
+    {
+        streamcarry(state);
+    }
+}
+
+void matchsolver::streamcarry(streamstate &state)
+{
+    if(!state.carry)
+    {
+        return;
+    }
+    state.carry=false;
+    if(state.carrylower.turn==0 && state.carrylower.raw==state.origin && !state.head)
+    {
+        state.head=true;
+        state.headupper=state.carryupper.raw;
+        return;
+    }
+    streamrange(state,anglerange(state.carrylower.raw,state.carryupper.raw));
+}
+
+void matchsolver::streamrange(streamstate &state, const anglerange &range)
+{
+    //the pieces in the sectors can't be pruned, a range may be wide but cut into narrow pieces by the sector borders.
+    if(range.getsize()<minwidth)
+    {
+        return;
+    }
+    state.count++;
+    if(state.target)
+    {
+        state.target->add(range);
+    }
+    if(state.sink)
+    {
+        state.sink->writefinalrange(state.commensurate,range);
+    }
+}
+
+void matchsolver::streamfinish(streamstate &state)
+{
+    //a carry that's left over reaches origin+2pi.
+    if(state.carry)
+    {
+        state.carry=false;
+        anglerange range;
+        if(state.carrylower.turn==0 && state.carrylower.raw==state.origin)
+        {
+            range.setcircle(true);
+        }
+        else if(state.head)
+        {
+            //around the origin
+            range=anglerange(state.carrylower.raw,state.headupper);
+            state.head=false;
+        }
+        else
+        {
+            range=anglerange(state.carrylower.raw,state.carryupper.raw);
+        }
+        streamrange(state,range);
+    }
+    if(state.head)
+    {
+        state.head=false;
+        streamrange(state,anglerange(state.origin,state.headupper));
+    }
+}
+
+void matchsolver::merge(hexloop &loop, angleset &newpx, angleset &newqx, angleset &newqy, angleset &newpy)
+{
+    //(px+dpx)x(qx+dqx) = pxxqx + dpxx(qx+dqx) + pxxdqx
+    loop.qxranges.add(newqx);
+    angleset newx = newpx.overlap(loop.qxranges);
+    newx.add(loop.pxranges.overlap(newqx));
+    loop.pxranges.add(newpx);
+    //same for y
+    loop.qyranges.add(newqy);
+    angleset newy = newpy.overlap(loop.qyranges);
+    newy.add(loop.pyranges.overlap(newqy));
+    loop.pyranges.add(newpy);
+
+    //commensurate: (x+dx)x(y+dy) = xxy + dxx(y+dy) + xxdy
+    loop.yoverlaps.add(newy);
+    angleset newboth=newx.overlap(loop.yoverlaps);
+    newboth.add(loop.xoverlaps.overlap(newy));
+    commensurate.add(newboth);
+    loop.xoverlaps.add(newx);
+
+    coincident.add(newx);
+    coincident.add(newy);
+}
+
+void matchsolver::refine(unsigned int maxindex)
+{
+    if(maxindex<=indexlimit && solved)
+    {
+        solvetime=0.0;
+        return;
+    }
+    if(!solved || minwidth>0.0)
+    {
+        //with a minimum width, as in extend(): a new piece can't tell if it makes a range wide enough, and
+        //ranges that were too narrow before are gone.
+        indexlimit=maxindex;
+        solvelimited();
+        fitresults();
+        return;
+    }
+    std::chrono::steady_clock::time_point start=std::chrono::steady_clock::now();
+    //the shell [old limit+1:maxindex], for the full range of b.
+    unsigned int from=indexlimit+1;
+    indexlimit=maxindex;
+    coincidentorders.clear();
+    commensurateorders.clear();
+    coincidentfits.clear();
+    commensuratefits.clear();
+    for(int hexcounter=0;hexcounter<loops;++hexcounter)
+    {
+        hexloop &loop = hexloops[hexcounter];
+        angleset newpx, newqx, newqy, newpy;
+        addpx(loop,from,capped(loop.maxn),params[B1MIN],params[B1MAX],&newpx);
+        addqx(loop,from,capped(loop.maxm),params[B2MIN],params[B2MAX],&newqx);
+        addqy(loop,from,capped(loop.maxo),params[B1MIN],params[B1MAX],&newqy);
+        addpy(loop,from,capped(loop.maxp),params[B2MIN],params[B2MAX],&newpy);
+        merge(loop,newpx,newqx,newqy,newpy);
+    }
+    coincident.sort();
+    commensurate.sort();
+    solvetime=std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+    //the ranges changed, the old fits are gone.
+    fitresults();
+}
+
+bool matchsolver::iscomplete() const
+{
+    for(int hexcounter=0;hexcounter<loops;++hexcounter)
+    {
+        const hexloop &loop = hexloops[hexcounter];
+        if(indexlimit<loop.maxn || indexlimit<loop.maxm || indexlimit<loop.maxo || indexlimit<loop.maxp)
+        {
+            return(false);
+        }
+    }
+    return(true);
+}
+
+unsigned int matchsolver::getindexlimit() const
+{
+    return(indexlimit);
+}
+
+void matchsolver::extend(double newb1max, double newb2max)
+{
+    if(newb1max<params[B1MAX] || newb2max<params[B2MAX])
+    {
+        throw std::invalid_argument("matchsolver::extend can only grow b1max and b2max.\n");
+    }
+    if(!solved)
+    {
+        params[B1MAX]=newb1max;
+        params[B2MAX]=newb2max;
+        return;
+    }
+    if(minwidth>0.0)
+    {
+        //a band only sees its own part of a range. Whether the whole range is wide enough is not known there,
+        //and ranges that were too narrow before are gone, so they can't grow. Solved anew, with the same limit.
+        params[B1MAX]=newb1max;
+        params[B2MAX]=newb2max;
+        solvelimited();
+        fitresults();
+        return;
+    }
+    std::chrono::steady_clock::time_point start=std::chrono::steady_clock::now();
+    //px and qy get a band added, and band borders may differ from a fresh generation in the last bits.
+    familiescomplete=false;
+    labels.clear();
+    multiplicity.clear();
+    coincidentorders.clear();
+    commensurateorders.clear();
+    coincidentfits.clear();
+    commensuratefits.clear();
+    for(int hexcounter=0;hexcounter<loops;++hexcounter)
+    {
+        hexloop &loop = hexloops[hexcounter];
+        setlimits(loop,newb1max,newb2max);
+        //The ranges of the old indices grow as well, so every index gets the band [old bmax:new bmax].
+        //The new indices are invalid for b below the old bmax anyhow, the clamping in the add functions takes care of that.
+        //If refine() left out the larger indices, they stay left out.
+        angleset newpx, newqx, newqy, newpy;
+        if(newb1max>params[B1MAX])
+        {
+            newpx.reserve(4*capped(loop.maxn));
+            addpx(loop,1,capped(loop.maxn),params[B1MAX],newb1max,&newpx,0,1,1,true);
+            newqy.reserve(4*capped(loop.maxo));
+            addqy(loop,1,capped(loop.maxo),params[B1MAX],newb1max,&newqy,0,1,1,true);
+        }
+        if(newb2max>params[B2MAX])
+        {
+            newqx.reserve(4*capped(loop.maxm));
+            addqx(loop,1,capped(loop.maxm),params[B2MAX],newb2max,&newqx,0,1,1,true);
+            newpy.reserve(4*capped(loop.maxp));
+            addpy(loop,1,capped(loop.maxp),params[B2MAX],newb2max,&newpy,0,1,1,true);
+        }
+        merge(loop,newpx,newqx,newqy,newpy);
+    }
+    params[B1MAX]=newb1max;
+    params[B2MAX]=newb2max;
+    coincident.sort();
+    commensurate.sort();
+    solvetime=std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+    //the ranges changed, the old fits are gone.
+    fitresults();
+}
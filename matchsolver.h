@@ -0,0 +1,371 @@
+/*
+ * LatticeMatch calculator - the actual solver
+ * Copyright (C) 2015 Andreas Grois
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ *
+ * This class holds everything that used to live in main(): the range families for px, qx, qy and py,
+ * their overlaps, and the resulting sets of coincident and commensurate matches.
+ * Keeping the intermediate families around allows to extend an already solved state when b1max or b2max
+ * grow, instead of redoing everything. Growing b1max by a band [oldb1max:newb1max] only adds ranges (every
+ * family is monotonic in b), so the new ranges can be generated for that band alone and merged into the
+ * existing consolidated sets.
+ *
+ * The input is expected to be sanitized already (see sanitize()): lengths positive, angles in radians,
+ * minimum values smaller than the maximum values.
+ *
+ * This class is part of the LatticeMatch program.
+ *
+ * To contact the author either use electronic mail: Andreas Grois <andreas.grois@jku.at>
+ * or write to:
+ * Andreas Grois, Institute for Semiconductor and SolidState physics, Johannes Kepler University,
+ * Altenbergerstraße 69, 4040 Linz, AUSTRIA
+ */
+
+#ifndef MATCHSOLVER_H
+#define MATCHSOLVER_H
+
+#include "angleset.h"
+#include "asintable.h"
+#include "provenance.h"
+#include "coverage.h"
+#include "bestangle.h"
+
+class rangescore;
+
+//receives the results of matchsolver::solve(sectors, sink) while the solver is still running.
+class matchsink
+{
+public:
+    virtual ~matchsink();
+    //a range of coincident or commensurate matches that is final: nothing will be added to it any more.
+    virtual void writefinalrange(bool commensurate, const anglerange &range)=0;
+    //called after each sector, a good moment to flush.
+    virtual void writesectordone()=0;
+};
+
+class matchsolver
+{
+public:
+    //same order as on the command line.
+    enum paramnames{A1,A2,ALPHA,B1MIN,B1MAX,B2MIN,B2MAX,BETAMIN,BETAMAX};
+    //what sanitize() had to fix, or-ed together.
+    enum sanitized{SANITIZED_B_SIGNS=1,SANITIZED_A_SIGNS=2,SANITIZED_WIDE_BETA=4};
+
+    //Never trust the user: turns the numbers as given on the command line (angles in degrees, any signs, minimum and
+    //maximum in any order) into what the solver expects. Negative lengths are flipped, and the angles changed to
+    //describe the same lattice. Returns the sanitized flags of what had to be fixed, SANITIZED_WIDE_BETA means the
+    //beta range is more than 180 degrees wide afterwards, which probably isn't what was meant.
+    static unsigned int sanitize(double input[9]);
+private:
+    //everything that belongs to one run with a given alpha. Hexagonal substrates need two of them.
+    struct hexloop
+    {
+        double alpha;
+        unsigned int maxn, maxm, maxo, maxp;
+        angleset pxranges;
+        angleset qxranges;
+        angleset qyranges;
+        angleset pyranges;
+        angleset xoverlaps;
+        angleset yoverlaps;
+        //the commensurate matches of the loop while intersect() works on them. Kept, so its storage is reused.
+        angleset both;
+        //px and qy as read by loadfamilies(). Taken instead of generating them, while the key matches.
+        angleset pxloaded;
+        angleset qyloaded;
+        //the index of every range of the families, in the order they were generated. Only with provenance.
+        std::vector<int> pxindices, qxindices, qyindices, pyindices;
+    };
+    //what px and qy depend on: A1, A2, ALPHA, B1MIN, B1MAX, minwidth, and 1 if the asin table is used, else 0.
+    struct familykey
+    {
+        double values[7];
+        bool operator==(const familykey &other) const;
+    };
+    familykey currentkey() const;
+    bool familiesloaded;
+    familykey loadedkey;
+    bool familiescomplete; //px and qy of all loops are there in full for the current parameters, see savefamilies()
+
+    double params[9];
+    char loops;
+    bool solved;
+    double solvetime; //seconds spent in the last solve(), extend() or refine()
+    unsigned int indexlimit; //indices above this are left out, see refine(). UINT_MAX if there is no limit.
+    hexloop hexloops[2];
+    angleset coincident;
+    angleset commensurate;
+    const asintable *asins; //0 means: use asin directly
+    double minwidth; //ranges narrower than this (radians) are dropped, see setminwidth()
+    double strain; //relative, see setstrain()
+    unsigned int maxdeterminant; //0: no limit, see setmaxdeterminant()
+    angleset allowed, restricted; //what the determinant limit allows, and the results cut to it. Kept for their storage.
+    unsigned int maxorder; //1: integer entries only, see setmaxorder()
+    //for every range of the results, the smallest denominator it needs. Only after solve() with a maxorder above 1.
+    std::vector<unsigned int> coincidentorders, commensurateorders;
+    bool labelling; //see setprovenance()
+    provenance labels;
+    bool counting; //see setcoverage()
+    coverage multiplicity;
+    bool fitting; //see setbestangles()
+    std::vector<bestangle::fit> coincidentfits, commensuratefits;
+    //the best angles of the results, if fitting is on.
+    void fitresults();
+
+    //the longest b1 and b2 that can still be part of a supercell within the determinant limit, at most b1max and b2max.
+    void areacaps(double &b1max, double &b2max) const;
+    //evaluates asin, either directly, or using the table. dir gives the direction in which the table result is rounded.
+    double evalasin(double x, int dir) const;
+    //the direction that has to be passed to evalasin for values at bmin to make ranges larger.
+    int outwards(const hexloop &loop) const;
+    //widens the range between the asin values at bmin and bmax of one index to b*(1-strain) and b*(1+strain).
+    //xatbmax is the argument of the asin at bmax before it was clamped, dir the direction it was rounded in.
+    //atbmin only moves if outer is set: bmin of a band added by extend() lies inside the ranges, it's no border.
+    void strainborders(double &atbmin, double &atbmax, double xatbmax, int dir, bool outer) const;
+    //the generation loops. They add the ranges for all indices in [from:to] and lengths of b in [bmin:bmax] to target.
+    //from==0 also adds the special case index 0, which doesn't depend on b at all.
+    //bmin may be too small for the larger indices, it's clamped. bmax only is with a strain, which raises the index limits.
+    //indices, if given, gets the signed index (n, m, o or p) of every range added to target, in the same order.
+    //The entries are i/order for every order from firstorder to lastorder, and the ranges of each order go to
+    //targets[order-firstorder]. Each index is visited once for all of them. Above order 1 only the fractions that
+    //can't be reduced are added, the others came with a smaller order already, and to is the index limit of
+    //lastorder, the smaller orders stop at their own, see orderlimit(). from must be at least 1 then.
+    //band says that bmin is the old bmax of extend(), not the end of the ranges.
+    void addpx(const hexloop &loop, unsigned int from, unsigned int to, double bmin, double bmax, angleset *targets, std::vector<int> *indices=0, unsigned int firstorder=1, unsigned int lastorder=1, bool band=false) const;
+    void addqx(const hexloop &loop, unsigned int from, unsigned int to, double bmin, double bmax, angleset *targets, std::vector<int> *indices=0, unsigned int firstorder=1, unsigned int lastorder=1, bool band=false) const;
+    void addqy(const hexloop &loop, unsigned int from, unsigned int to, double bmin, double bmax, angleset *targets, std::vector<int> *indices=0, unsigned int firstorder=1, unsigned int lastorder=1, bool band=false) const;
+    void addpy(const hexloop &loop, unsigned int from, unsigned int to, double bmin, double bmax, angleset *targets, std::vector<int> *indices=0, unsigned int firstorder=1, unsigned int lastorder=1, bool band=false) const;
+    //the index limits for a given alpha and b1max, b2max
+    void setlimits(hexloop &loop, double b1max, double b2max) const;
+    //the index limit of setlimits() for entries i/order of a lattice constant a, sine being sin(alpha) of the loop.
+    unsigned int orderlimit(double bmax, double a, double sine, unsigned int order) const;
+    //the largest index that is actually used, if maximum is the one the window allows
+    unsigned int capped(unsigned int maximum) const;
+    //generates the four families of a loop from scratch, without consolidating them.
+    void generate(hexloop &loop);
+    //the overlaps of the four families of a loop, pruned to the minimum width, added to the results.
+    void intersect(hexloop &loop);
+    //solve(), for the current indexlimit
+    void solvelimited();
+    //the fractions of orders 2 to maxorder, added to what solvelimited() found, and the orders of the results.
+    void solveorders();
+    //the smallest order of the snapshots that touches each range of results. Every snapshot range lies within one of them.
+    static void tagorders(const std::vector<anglerange> &results, const std::vector<std::vector<anglerange> > &snapshots, std::vector<unsigned int> &orders);
+    //adds new ranges of the four families to a solved loop, and the matches they give to the results.
+    //Not with a minimum width: a new piece may be what makes a range wide enough, and ranges that were pruned
+    //before are gone. The callers solve or intersect anew instead.
+    void merge(hexloop &loop, angleset &newpx, angleset &newqx, angleset &newqy, angleset &newpy);
+
+    //the families from scratch, for all indices, and nothing else. For the sector-wise solvers.
+    void generateall();
+    //the x and y overlaps of a loop inside one sector, and their overlap. Narrow ones are pruned, as long as they
+    //don't touch the sector borders.
+    void sectoroverlaps(hexloop &loop, const anglerange &sector, angleset &x, angleset &y);
+    angleset sectorboth(angleset &x, angleset &y, const anglerange &sector) const;
+    //solve(sectors, sink). keep=false keeps neither the results nor the overlaps, the ranges only go to sink.
+    void solvesectors(unsigned int sectors, matchsink *sink, bool keep);
+    //countcommensurate(). stopatfirst stops after the sector in which the first range was found.
+    unsigned long countsectors(bool stopatfirst);
+    //sectors used by the query modes
+    static const unsigned int querysectors=64;
+
+    //an angle unwrapped to [origin:origin+2pi], so the ranges of one sector are just intervals. Not as
+    //raw+2pi: that would round, and ranges a few ulps apart would join up.
+    struct sweepangle
+    {
+        int turn; //1 for angles that come after 2pi, when going around from origin
+        double raw; //in [0:2pi)
+        bool operator<(const sweepangle &other) const;
+        bool operator<=(const sweepangle &other) const;
+    };
+    //border k of the sweep starting at origin. The last border is exactly origin+2pi, so the last
+    //sector ends where the first one starts.
+    static sweepangle sectorborder(unsigned int k, unsigned int sectors, double origin);
+
+    //one of the result sets while streaming.
+    struct streamstate
+    {
+        bool commensurate;
+        double origin; //where the first sector starts, in [0:2pi)
+        angleset *target; //where the final ranges go, 0 if they aren't kept
+        matchsink *sink; //who hears about them right away, may be 0
+        unsigned long count; //final ranges so far
+        bool carry; //the last range seen. Not final yet, if it touches the upper border of the sector.
+        sweepangle carrylower, carryupper;
+        bool head; //the first range, if it starts at origin. It might continue the last one, around the circle.
+        double headupper;
+    };
+    //a sector-wise solve that is under way. solvesectors() runs it to the end, rangeiterator one sector at a time.
+    struct sectorsweep
+    {
+        unsigned int sectors;
+        unsigned int next; //the next sector, sectors for the final step, above that the sweep is done.
+        matchsink *sink;
+        bool keep;
+        streamstate states[2];
+    };
+    sectorsweep sweep;
+    //generates the families and sets up a sweep starting at origin. See solvesectors() for sink and keep.
+    void startsweep(unsigned int sectors, double origin, matchsink *sink, bool keep);
+    //does the next sector, or after the last one hands out what's left. false if the sweep was done already.
+    bool sweepstep();
+    friend class rangeiterator;
+    void streamsector(streamstate &state, angleset &sectorset, const sweepangle &sectorlower, const sweepangle &sectorupper);
+    void streamrange(streamstate &state, const anglerange &range);
+    void streamcarry(streamstate &state);
+    void streamfinish(streamstate &state);
+public:
+    matchsolver();
+    //input in the order given by paramnames, sanitized.
+    matchsolver(const double input[9]);
+
+    void setparams(const double input[9]);
+    double getparam(paramnames which) const;
+    //number of alpha values that are being looked at: 2 for hexagonal substrates, 1 otherwise
+    int getloops() const;
+
+    //use a table for the arcsine instead of evaluating it. Pass 0 to go back to asin.
+    //The table is not owned by the solver, it has to outlive it.
+    void setasintable(const asintable *table);
+
+    //ranges narrower than width (radians) are of no interest. Indices whose family ranges are already narrower
+    //are skipped during generation (an overlap can't be wider than the ranges it comes from), and narrow x and y
+    //overlaps are dropped before they are combined or intersected any further. This is a pruning, not a filter:
+    //a range that is only wide because narrow pieces join up gets lost as well. 0, the default, keeps everything.
+    void setminwidth(double width);
+
+    //a film that takes up to this relative strain (0.01 for 1%) still matches. b1 and b2 may then be that much
+    //longer or shorter than their windows allow, and beta may be off by twice it (radians), which is as far as a
+    //strain that small can turn two vectors against each other. Each generated range is widened right away
+    //instead of solving again with wider windows: its borders are evaluated at bmin*(1-strain) and bmax*(1+strain).
+    //The index limits are those of bmax*(1+strain), so indices that only fit because of the strain are there too.
+    //px and qy of a strained solve are never saved or loaded, see savefamilies(). 0, the default, is off.
+    void setstrain(double relative);
+
+    //px and qy only depend on the substrate and the b1 window, and are the same for every adlayer that is tried
+    //on it. savefamilies() writes those of the last solve to a file: consolidated, sorted, with the parameters
+    //they belong to. false if the file can't be written, or there is nothing complete to save (not solved since
+    //setparams(), or extend() or a limited refine() came after it).
+    //loadfamilies() reads such a file. From then on, every solve whose A1, A2, ALPHA, B1MIN, B1MAX, minimum
+    //width and asin table use are exactly those of the file takes px and qy from it instead of generating them.
+    //Other solves generate them as usual. false if the file can't be read or isn't one of ours.
+    bool savefamilies(const char *filename);
+    bool loadfamilies(const char *filename);
+
+    //supercells of more than limit substrate cells are of no interest: commensurate matches need an epitaxy matrix
+    //with |px*py-qx*qy|<=limit. As that area is also b1*b2*|sin(beta)|, b1 can be at most limit times the substrate
+    //cell over b2min*|sin(beta)|, at the smallest |sin(beta)| of the window, and b2 likewise. The families are only
+    //generated up to there, for all ways of solving, so the index loops stop early. solve() also tracks the
+    //indices, like provenance, and only makes the commensurate overlaps of matrices within the limit. The
+    //coincident ones only fix one column, they just get the shorter windows. Families aren't saved or loaded
+    //with it. 0, the default, is no limit.
+    void setmaxdeterminant(unsigned int limit);
+
+    //coincidence of higher order: entries of the epitaxy matrix may also be fractions k/d with a denominator d of
+    //at most order, not just integers. solve() first solves for the integers as usual, and then adds the
+    //fractions of each denominator in turn, the way refine() adds indices: only the new ranges of the families
+    //are generated, with the asin arguments of index k simply divided by d, and fractions that reduce to a
+    //smaller denominator are skipped, their ranges are there already. The generation visits every k once for
+    //all denominators, k*a*sin(alpha)/b at the two ends of the window is computed once and shared by them. Every result range is tagged with the
+    //smallest denominator that gives a match in it, see getorders(). Provenance and the determinant limit only
+    //know integer matrices, they don't go with it, and families aren't saved. 1, the default, is integers only.
+    void setmaxorder(unsigned int order);
+    //the orders of the ranges of getcoincident() or getcommensurate(), in the same order as getrangesref().
+    //Empty unless the last solve() had a maximum order above 1.
+    const std::vector<unsigned int>& getorders(bool commensurate) const;
+
+    //keep track of which epitaxy matrices (n, m, o, p) every result range comes from, see provenance.h. Only solve()
+    //does it, everything else leaves getprovenance() empty. Costs time and memory in proportion to the number of
+    //overlapping pairs of ranges, and px and qy are always generated, never taken from loadfamilies().
+    void setprovenance(bool on);
+    //the labels of the last solve(). isvalid() is false if provenance is off, or something else ran since.
+    const provenance& getprovenance() const;
+
+    //count how many index combinations hit each theta, see coverage.h. Only solve() does it, from the families
+    //as they were generated, with their indices like provenance, so px and qy are never taken from loadfamilies()
+    //then. The counts are those of the integer indices, fractions added by setmaxorder() and the determinant
+    //limit aren't looked at.
+    void setcoverage(bool on);
+    //the counts of the last solve(). isvalid() is false if counting is off, or something else ran since.
+    const coverage& getcoverage() const;
+
+    //find the best angle inside every result range, and the misfit of the epitaxy matrix there, see bestangle.h.
+    //solve(), solvetop(), refine() and extend() do it at the end, everything else leaves getfits() empty.
+    void setbestangles(bool on);
+    //the fits of the ranges of getcoincident() or getcommensurate(), in the same order as getrangesref().
+    const std::vector<bestangle::fit>& getfits(bool commensurate) const;
+
+    //does the full calculation. Afterwards coincident and commensurate are consolidated and sorted.
+    void solve();
+
+    //the same, but the circle is cut into sectors, which are solved one after the other, starting at 0.
+    //Every range that can't change any more is passed to sink right away, so the first results are out long
+    //before the calculation is done. The ranges come in ascending order, except one that starts at exactly 0:
+    //it is held back until the end, in case the last sector continues it. Afterwards everything is the same
+    //as after solve(). sectors is at least 2.
+    void solve(unsigned int sectors, matchsink &sink);
+
+    //only the k best ranges of each set, by score (see rangescore). The ranges are streamed into a bounded heap,
+    //the others are never stored or sorted. Afterwards getcoincident() and getcommensurate() hold the selected
+    //ranges, sorted by lower border as usual. The solver counts as not solved, extend() doesn't work on this.
+    void solvetop(unsigned int k, const rangescore &score);
+
+    //commensurate matches only, by enumerating the integer epitaxy matrices instead of intersecting the families,
+    //see matrixenumerator.h. Much faster for small supercells. Afterwards getcommensurate() holds a point for every
+    //theta that has at least one matrix, getcoincident() is empty. Returns the number of matrices. The minimum
+    //width is not applied, the points are exact. The solver counts as not solved, extend() doesn't work on this.
+    unsigned long solveenumerated();
+
+    //both sets by brute force, see thetascan.h: theta is looked at on a grid of points steps around the circle, and
+    //every run of neighbouring grid points that match becomes one range, from the first point to the last. A
+    //cross-check for the ranges, not a replacement: anything narrower than a step can fall through the grid.
+    //The minimum width is not applied. The solver counts as not solved, extend() doesn't work on this.
+    void solvescan(unsigned int points);
+
+    //query modes, for screening: they answer a question about the commensurate matches without calculating
+    //all of them. Both go around the circle sector by sector, like solve(sectors, sink), and keep nothing.
+    //Afterwards the solver counts as not solved, getcoincident() and getcommensurate() are empty.
+    //true if there is any commensurate match. Stops at the first sector that has one.
+    bool findcommensurate();
+    //the number of distinct commensurate ranges, as solve() would give them.
+    unsigned long countcommensurate();
+
+    //grows b1max and b2max to the given values, and updates the results accordingly.
+    //Only the new band of b values is generated. The new values must not be smaller than the old ones.
+    //If the solver has not been run yet, this just changes the parameters. With a minimum width it solves
+    //anew, as a band can't tell which of its pieces belong to a range that is wide enough. Like refine(), it
+    //fits the results again if setbestangles() is on, and only knows integer entries: getorders() is empty after it.
+    void extend(double newb1max, double newb2max);
+
+    //anytime solving: makes the results complete for all indices n, m, o, p up to maxindex, but leaves out
+    //larger ones. Small indices are the cheap and physically most relevant matches, so calling this with
+    //growing maxindex gives useful results early. On a solver that hasn't been solved since setparams() this
+    //is a solve() restricted to those indices, afterwards only the indices above the previous limit are added.
+    //With a minimum width it solves anew up to maxindex, like extend(). extend() keeps the limit. solve() removes it.
+    void refine(unsigned int maxindex);
+    //true if no index has been left out, so the results are the same as after solve()
+    bool iscomplete() const;
+    unsigned int getindexlimit() const;
+
+    //wall clock time of the last solve(), extend() or refine(), in seconds
+    double getsolvetime() const;
+
+    angleset& getcoincident();
+    angleset& getcommensurate();
+};
+
+#endif // MATCHSOLVER_H
@@ -0,0 +1,150 @@
+/*
+ * LatticeMatch calculator - commensurate matches by enumerating epitaxy matrices
+ * Copyright (C) 2015 Andreas Grois
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ *
+ * See matrixenumerator.h.
+ *
+ * This class is part of the LatticeMatch program.
+ *
+ * To contact the author either use electronic mail: Andreas Grois <andreas.grois@jku.at>
+ * or write to:
+ * Andreas Grois, Institute for Semiconductor and SolidState physics, Johannes Kepler University,
+ * Altenbergerstraße 69, 4040 Linz, AUSTRIA
+ */
+
+#include "matrixenumerator.h"
+#include "matchsolver.h"
+#include <cmath>
+#include <algorithm>
+
+//matches exactly on a border of the windows (a lattice vector of exactly b1min, say) shouldn't get lost to rounding.
+static const double slack=1e-12;
+
+bool matrixenumerator::latticevector::operator<(const latticevector &other) const
+{
+    return(angle<other.angle);
+}
+
+matrixenumerator::matrixenumerator(const double input[9])
+{
+    for(int i=0;i<9;i++)
+    {
+        params[i]=input[i];
+    }
+}
+
+void matrixenumerator::vectors(double bmin, double bmax, bool upperhalf, std::vector<latticevector> &target) const
+{
+    const double a1=params[matchsolver::A1], a2=params[matchsolver::A2], alpha=params[matchsolver::ALPHA];
+    const double lower=bmin*(1.0-slack), upper=bmax*(1.0+slack);
+    //rows are a2*|sin(alpha)| apart, the ones further out than bmax can't have anything.
+    const int maxo=floor(upper/(a2*fabs(sin(alpha))));
+    for(int o = upperhalf && sin(alpha)>0 ? 0 : -maxo; o<=(upperhalf && sin(alpha)<0 ? 0 : maxo); o++)
+    {
+        const double y=o*a2*sin(alpha);
+        const double shift=o*a2*cos(alpha);
+        const double outer=upper*upper-y*y;
+        if(outer<0.0)
+        {
+            continue;
+        }
+        //x=n*a1+shift has to be in [-xmax:-xmin] or [xmin:xmax].
+        const double xmax=sqrt(outer);
+        const double xmin=sqrt(fmax(0.0,lower*lower-y*y));
+        const int bounds[2][2]={{static_cast<int>(ceil((-xmax-shift)/a1)),static_cast<int>(floor((-xmin-shift)/a1))},
+                                {static_cast<int>(ceil((xmin-shift)/a1)),static_cast<int>(floor((xmax-shift)/a1))}};
+        for(int side=0;side<2;side++)
+        {
+            //xmin=0: both intervals meet at the middle, that n must not come twice.
+            const int from = (side==1 && bounds[0][1]>=bounds[1][0]) ? bounds[0][1]+1 : bounds[side][0];
+            for(int n=from;n<=bounds[side][1];n++)
+            {
+                const double x=n*a1+shift;
+                const double length=sqrt(x*x+y*y);
+                if(length<lower || length>upper)
+                {
+                    continue;
+                }
+                latticevector v;
+                v.n=n;
+                v.o=o;
+                v.angle=atan2(y,x);
+                if(v.angle<0.0)
+                {
+                    v.angle+=2*M_PI;
+                }
+                if(v.angle>=2*M_PI)
+                {
+                    v.angle=0.0;
+                }
+                if(upperhalf && v.angle>=M_PI)
+                {
+                    continue;
+                }
+                target.push_back(v);
+            }
+        }
+    }
+}
+
+void matrixenumerator::enumerate(std::vector<match> &matches) const
+{
+    std::vector<latticevector> firsts, seconds;
+    vectors(params[matchsolver::B1MIN],params[matchsolver::B1MAX],true,firsts);
+    vectors(params[matchsolver::B2MIN],params[matchsolver::B2MAX],false,seconds);
+    std::sort(seconds.begin(),seconds.end());
+    const double width=params[matchsolver::BETAMAX]-params[matchsolver::BETAMIN]+2*slack;
+    const size_t start=matches.size();
+    for(std::vector<latticevector>::const_iterator b1=firsts.begin();b1!=firsts.end();++b1)
+    {
+        //the angles of b2 that fit, cut in two if they go through 0.
+        double lower=fmod(b1->angle+params[matchsolver::BETAMIN]-slack,2*M_PI);
+        if(lower<0.0)
+        {
+            lower+=2*M_PI;
+        }
+        const double windows[2][2]={{lower,fmin(lower+width,2*M_PI)},{0.0,lower+width-2*M_PI}};
+        for(int w=0;w<2;w++)
+        {
+            if(windows[w][1]<windows[w][0])
+            {
+                continue;
+            }
+            latticevector key;
+            key.angle=windows[w][0];
+            for(std::vector<latticevector>::const_iterator b2=std::lower_bound(seconds.begin(),seconds.end(),key);b2!=seconds.end() && b2->angle<=windows[w][1];++b2)
+            {
+                match found;
+                found.theta=b1->angle;
+                found.px=b1->n;
+                found.qy=b1->o;
+                found.qx=b2->n;
+                found.py=b2->o;
+                matches.push_back(found);
+                //and the same turned by 180 degrees
+                found.theta=b1->angle+M_PI;
+                found.px=-found.px;
+                found.qy=-found.qy;
+                found.qx=-found.qx;
+                found.py=-found.py;
+                matches.push_back(found);
+            }
+        }
+    }
+    std::sort(matches.begin()+start,matches.end(),[](const match &a, const match &b){ return(a.theta<b.theta); });
+}
@@ -0,0 +1,78 @@
+/*
+ * LatticeMatch calculator - commensurate matches by enumerating epitaxy matrices
+ * Copyright (C) 2015 Andreas Grois
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ *
+ * A commensurate match has all four entries of the epitaxy matrix integer, so both adlayer vectors are
+ * substrate lattice vectors:
+ *   b1 = px*a1 + qy*a2
+ *   b2 = qx*a1 + py*a2
+ * Instead of intersecting the four families of ranges, this goes the other way round: it lists the lattice
+ * vectors whose length is within [b1min:b1max], and those within [b2min:b2max], and pairs them up wherever
+ * the angle from b1 to b2 is within [betamin:betamax]. Every pair is a matrix, and fixes theta (the angle of
+ * b1), b1, b2 and beta exactly.
+ *
+ * For each row (fixed multiple of a2) the admissible multiples of a1 follow from |b|^2 in closed form, so
+ * only vectors inside the annulus are ever looked at. b2 candidates are sorted by angle, and for each b1 the
+ * beta window is found by binary search. Only b1 in the upper half plane is enumerated: -b1, -b2 is a match
+ * whenever b1, b2 is one, at theta+180 degrees. Lattice vectors of a hexagonal substrate are all reached with
+ * the first basis, so there is no second run.
+ *
+ * The result is exact points in theta rather than ranges. The range solver describes each column on its own,
+ * with its own b and beta, so its commensurate ranges contain these points, but are wider, and can contain
+ * none of them at all.
+ *
+ * This class is part of the LatticeMatch program.
+ *
+ * To contact the author either use electronic mail: Andreas Grois <andreas.grois@jku.at>
+ * or write to:
+ * Andreas Grois, Institute for Semiconductor and SolidState physics, Johannes Kepler University,
+ * Altenbergerstraße 69, 4040 Linz, AUSTRIA
+ */
+
+#ifndef MATRIXENUMERATOR_H
+#define MATRIXENUMERATOR_H
+
+#include <vector>
+
+class matrixenumerator
+{
+public:
+    struct match
+    {
+        double theta; //radians, in [0:2pi)
+        int px, qx, qy, py;
+    };
+private:
+    double params[9];
+    //a lattice vector n*a1+o*a2
+    struct latticevector
+    {
+        double angle; //to a1, in [0:2pi)
+        int n, o;
+        bool operator<(const latticevector &other) const;
+    };
+    //all lattice vectors with lengths in [bmin:bmax]. upperhalf: only those with angles in [0:pi).
+    void vectors(double bmin, double bmax, bool upperhalf, std::vector<latticevector> &target) const;
+public:
+    //sanitized parameters, as for matchsolver.
+    matrixenumerator(const double input[9]);
+    //adds every matrix to matches, sorted by theta.
+    void enumerate(std::vector<match> &matches) const;
+};
+
+#endif // MATRIXENUMERATOR_H
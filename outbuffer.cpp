@@ -0,0 +1,536 @@
+/*
+ * LatticeMatch calculator - buffered output
+ * Copyright (C) 2015 Andreas Grois
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ *
+ * A large, reusable output buffer that is written to a file descriptor with a single write call per flush.
+ * It also does the number formatting, because iostreams are slow at that:
+ * o) appendg() gives exactly what printf's %g (and therefore cout's default formatting) would print,
+ *    but for the usual precisions it gets the digits with a single multiplication instead of going through
+ *    the locale machinery. Only if the result is too close to a rounding tie it asks snprintf.
+ * o) appendshortest() prints the shortest representation that reads back to the very same double.
+ *
+ * This class is part of the LatticeMatch program.
+ *
+ * To contact the author either use electronic mail: Andreas Grois <andreas.grois@jku.at>
+ * or write to:
+ * Andreas Grois, Institute for Semiconductor and SolidState physics, Johannes Kepler University,
+ * Altenbergerstraße 69, 4040 Linz, AUSTRIA
+ */
+
+#include "outbuffer.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+#include <stdint.h>
+#ifdef _WIN32
+#include <io.h>
+#define write _write
+#else
+#include <unistd.h>
+#endif
+
+//exact powers of ten. Everything up to 1e22 is exactly representable as double.
+static const double powersoften[]={1e0,1e1,1e2,1e3,1e4,1e5,1e6,1e7,1e8,1e9,1e10,1e11,1e12,1e13,1e14,1e15,1e16,1e17,1e18,1e19,1e20,1e21,1e22};
+
+//Grisu3, from F. Loitsch, "Printing Floating-Point Numbers Quickly and Accurately with Integers", PLDI 2010.
+//The double and the borders of the interval that reads back to it are scaled by a cached power of ten into
+//64 bit integers, and digits are generated until the number lies within that interval. That gives the
+//shortest digits, and of those the closest. For about 0.5% of all doubles the 64 bits aren't precise enough
+//to be sure, then it says so and the caller has to take another way.
+
+//f*2^e
+struct diyfp
+{
+    uint64_t f;
+    int e;
+};
+
+//10^decimal, rounded to 64 bits: fraction*2^binary. Every 8th power from 10^-348 to 10^340.
+struct cachedpower
+{
+    uint64_t fraction;
+    int binary, decimal;
+};
+
+static const cachedpower cachedpowers[]={
+    {0xfa8fd5a0081c0288ULL,-1220,-348}, {0xbaaee17fa23ebf76ULL,-1193,-340}, {0x8b16fb203055ac76ULL,-1166,-332},
+    {0xcf42894a5dce35eaULL,-1140,-324}, {0x9a6bb0aa55653b2dULL,-1113,-316}, {0xe61acf033d1a45dfULL,-1087,-308},
+    {0xab70fe17c79ac6caULL,-1060,-300}, {0xff77b1fcbebcdc4fULL,-1034,-292}, {0xbe5691ef416bd60cULL,-1007,-284},
+    {0x8dd01fad907ffc3cULL,-980,-276}, {0xd3515c2831559a83ULL,-954,-268}, {0x9d71ac8fada6c9b5ULL,-927,-260},
+    {0xea9c227723ee8bcbULL,-901,-252}, {0xaecc49914078536dULL,-874,-244}, {0x823c12795db6ce57ULL,-847,-236},
+    {0xc21094364dfb5637ULL,-821,-228}, {0x9096ea6f3848984fULL,-794,-220}, {0xd77485cb25823ac7ULL,-768,-212},
+    {0xa086cfcd97bf97f4ULL,-741,-204}, {0xef340a98172aace5ULL,-715,-196}, {0xb23867fb2a35b28eULL,-688,-188},
+    {0x84c8d4dfd2c63f3bULL,-661,-180}, {0xc5dd44271ad3cdbaULL,-635,-172}, {0x936b9fcebb25c996ULL,-608,-164},
+    {0xdbac6c247d62a584ULL,-582,-156}, {0xa3ab66580d5fdaf6ULL,-555,-148}, {0xf3e2f893dec3f126ULL,-529,-140},
+    {0xb5b5ada8aaff80b8ULL,-502,-132}, {0x87625f056c7c4a8bULL,-475,-124}, {0xc9bcff6034c13053ULL,-449,-116},
+    {0x964e858c91ba2655ULL,-422,-108}, {0xdff9772470297ebdULL,-396,-100}, {0xa6dfbd9fb8e5b88fULL,-369,-92},
+    {0xf8a95fcf88747d94ULL,-343,-84}, {0xb94470938fa89bcfULL,-316,-76}, {0x8a08f0f8bf0f156bULL,-289,-68},
+    {0xcdb02555653131b6ULL,-263,-60}, {0x993fe2c6d07b7facULL,-236,-52}, {0xe45c10c42a2b3b06ULL,-210,-44},
+    {0xaa242499697392d3ULL,-183,-36}, {0xfd87b5f28300ca0eULL,-157,-28}, {0xbce5086492111aebULL,-130,-20},
+    {0x8cbccc096f5088ccULL,-103,-12}, {0xd1b71758e219652cULL,-77,-4}, {0x9c40000000000000ULL,-50,4},
+    {0xe8d4a51000000000ULL,-24,12}, {0xad78ebc5ac620000ULL,3,20}, {0x813f3978f8940984ULL,30,28},
+    {0xc097ce7bc90715b3ULL,56,36}, {0x8f7e32ce7bea5c70ULL,83,44}, {0xd5d238a4abe98068ULL,109,52},
+    {0x9f4f2726179a2245ULL,136,60}, {0xed63a231d4c4fb27ULL,162,68}, {0xb0de65388cc8ada8ULL,189,76},
+    {0x83c7088e1aab65dbULL,216,84}, {0xc45d1df942711d9aULL,242,92}, {0x924d692ca61be758ULL,269,100},
+    {0xda01ee641a708deaULL,295,108}, {0xa26da3999aef774aULL,322,116}, {0xf209787bb47d6b85ULL,348,124},
+    {0xb454e4a179dd1877ULL,375,132}, {0x865b86925b9bc5c2ULL,402,140}, {0xc83553c5c8965d3dULL,428,148},
+    {0x952ab45cfa97a0b3ULL,455,156}, {0xde469fbd99a05fe3ULL,481,164}, {0xa59bc234db398c25ULL,508,172},
+    {0xf6c69a72a3989f5cULL,534,180}, {0xb7dcbf5354e9beceULL,561,188}, {0x88fcf317f22241e2ULL,588,196},
+    {0xcc20ce9bd35c78a5ULL,614,204}, {0x98165af37b2153dfULL,641,212}, {0xe2a0b5dc971f303aULL,667,220},
+    {0xa8d9d1535ce3b396ULL,694,228}, {0xfb9b7cd9a4a7443cULL,720,236}, {0xbb764c4ca7a44410ULL,747,244},
+    {0x8bab8eefb6409c1aULL,774,252}, {0xd01fef10a657842cULL,800,260}, {0x9b10a4e5e9913129ULL,827,268},
+    {0xe7109bfba19c0c9dULL,853,276}, {0xac2820d9623bf429ULL,880,284}, {0x80444b5e7aa7cf85ULL,907,292},
+    {0xbf21e44003acdd2dULL,933,300}, {0x8e679c2f5e44ff8fULL,960,308}, {0xd433179d9c8cb841ULL,986,316},
+    {0x9e19db92b4e31ba9ULL,1013,324}, {0xeb96bf6ebadf77d9ULL,1039,332}, {0xaf87023b9bf0ee6bULL,1066,340},
+};
+
+static diyfp multiply(diyfp x, diyfp y)
+{
+    //the upper 64 bits of the 128 bit product, rounded.
+    const uint64_t mask=0xffffffffULL;
+    const uint64_t a=x.f>>32, b=x.f&mask, c=y.f>>32, d=y.f&mask;
+    const uint64_t ac=a*c, bc=b*c, ad=a*d, bd=b*d;
+    uint64_t middle=(bd>>32)+(ad&mask)+(bc&mask);
+    middle+=1ULL<<31;
+    diyfp result={ac+(ad>>32)+(bc>>32)+(middle>>32),x.e+y.e+64};
+    return(result);
+}
+
+static diyfp normalized(diyfp n)
+{
+    while(!(n.f&0xffc0000000000000ULL))
+    {
+        n.f<<=10;
+        n.e-=10;
+    }
+    while(!(n.f&0x8000000000000000ULL))
+    {
+        n.f<<=1;
+        n.e--;
+    }
+    return(n);
+}
+
+//the largest power of ten not above n, which has bits bits, and its exponent plus 1.
+static int largestpoweroften(uint32_t n, int bits, uint32_t &power)
+{
+    static const uint32_t powers[]={0,1,10,100,1000,10000,100000,1000000,10000000,100000000,1000000000};
+    int guess=((bits+1)*1233>>12)+1;
+    if(n<powers[guess])
+    {
+        guess--;
+    }
+    power=powers[guess];
+    return(guess);
+}
+
+//moves the last digit towards w, as long as that stays within the interval, and tells if the result is safe.
+static bool roundweed(char *digits, int length, uint64_t distance, uint64_t delta, uint64_t rest, uint64_t tenkappa, uint64_t unit)
+{
+    const uint64_t smalldistance=distance-unit, bigdistance=distance+unit;
+    while(rest<smalldistance && delta-rest>=tenkappa && (rest+tenkappa<smalldistance || smalldistance-rest>=rest+tenkappa-smalldistance))
+    {
+        digits[length-1]--;
+        rest+=tenkappa;
+    }
+    if(rest<bigdistance && delta-rest>=tenkappa && (rest+tenkappa<bigdistance || bigdistance-rest>rest+tenkappa-bigdistance))
+    {
+        return(false);
+    }
+    return(2*unit<=rest && rest<=delta-4*unit);
+}
+
+static bool digitgen(diyfp low, diyfp w, diyfp high, char *digits, int &length, int &kappa)
+{
+    uint64_t unit=1;
+    const diyfp toolow={low.f-unit,low.e}, toohigh={high.f+unit,high.e};
+    uint64_t unsafe=toohigh.f-toolow.f;
+    const diyfp one={1ULL<<-w.e,w.e};
+    uint32_t integral=static_cast<uint32_t>(toohigh.f>>-one.e);
+    uint64_t fractional=toohigh.f&(one.f-1);
+    uint32_t divisor;
+    kappa=largestpoweroften(integral,64+one.e,divisor);
+    length=0;
+    while(kappa>0)
+    {
+        digits[length++]=static_cast<char>('0'+integral/divisor);
+        integral%=divisor;
+        kappa--;
+        const uint64_t rest=(static_cast<uint64_t>(integral)<<-one.e)+fractional;
+        if(rest<unsafe)
+        {
+            return(roundweed(digits,length,toohigh.f-w.f,unsafe,rest,static_cast<uint64_t>(divisor)<<-one.e,unit));
+        }
+        divisor/=10;
+    }
+    for(;;)
+    {
+        fractional*=10;
+        unit*=10;
+        unsafe*=10;
+        digits[length++]=static_cast<char>('0'+(fractional>>-one.e));
+        fractional&=one.f-1;
+        kappa--;
+        if(fractional<unsafe)
+        {
+            return(roundweed(digits,length,(toohigh.f-w.f)*unit,unsafe,fractional,one.f,unit));
+        }
+    }
+}
+
+//the shortest digits of a positive, finite value, which is digits*10^exponent. false if it can't be sure.
+static bool grisu3(double value, char *digits, int &length, int &exponent)
+{
+    uint64_t bits;
+    memcpy(&bits,&value,sizeof(bits));
+    const uint64_t fractionmask=0x000fffffffffffffULL, exponentmask=0x7ff0000000000000ULL;
+    diyfp v;
+    if(bits&exponentmask)
+    {
+        v.f=(bits&fractionmask)+0x0010000000000000ULL;
+        v.e=static_cast<int>((bits&exponentmask)>>52)-1075;
+    }
+    else
+    {
+        v.f=bits&fractionmask;
+        v.e=-1074;
+    }
+    diyfp w=normalized(v);
+    //the borders are halfway to the neighbours. The one below is closer if v is a power of two.
+    const diyfp above={(v.f<<1)+1,v.e-1};
+    diyfp high=normalized(above);
+    diyfp low;
+    if(!(bits&fractionmask) && (bits&exponentmask))
+    {
+        low.f=(v.f<<2)-1;
+        low.e=v.e-2;
+    }
+    else
+    {
+        low.f=(v.f<<1)-1;
+        low.e=v.e-1;
+    }
+    low.f<<=low.e-high.e;
+    low.e=high.e;
+    //a power of ten that brings w to a binary exponent between -60 and -32.
+    const int k=static_cast<int>(ceil((-60-64-w.e+63)*0.30102999566398114));
+    const cachedpower &power=cachedpowers[(k+348-1)/8+1];
+    const diyfp scale={power.fraction,power.binary};
+    w=multiply(w,scale);
+    low=multiply(low,scale);
+    high=multiply(high,scale);
+    int kappa;
+    const bool sure=digitgen(low,w,high,digits,length,kappa);
+    exponent=kappa-power.decimal;
+    return(sure);
+}
+
+outbuffer::outbuffer(int fd, size_t capacity)
+{
+    this->fd=fd;
+    buffer.resize(capacity);
+    used=0;
+    threshold=capacity/2;
+    error=0;
+}
+
+outbuffer::~outbuffer()
+{
+    flush();
+}
+
+void outbuffer::grow(size_t extra)
+{
+    if(used+extra>buffer.size())
+    {
+        buffer.resize(std::max(2*buffer.size(),used+extra));
+    }
+}
+
+void outbuffer::append(char c)
+{
+    grow(1);
+    buffer[used++]=c;
+}
+
+void outbuffer::append(const char *text)
+{
+    append(text,strlen(text));
+}
+
+void outbuffer::append(const char *data, size_t length)
+{
+    grow(length);
+    memcpy(&buffer[used],data,length);
+    used+=length;
+}
+
+void outbuffer::appendu(unsigned long long value)
+{
+    char digits[24];
+    int pos=24;
+    do
+    {
+        digits[--pos]='0'+value%10;
+        value/=10;
+    } while(value);
+    append(digits+pos,24-pos);
+}
+
+void outbuffer::appendg(double value, int precision)
+{
+    grow(32);
+    double absval=fabs(value);
+    //the fast path: the precision is small enough that a double holds all digits with room to spare,
+    //and the value is in a range where the scaling factor is an exact power of ten.
+    if(precision>=1 && precision<=9 && absval>=1e-12 && absval<1e15)
+    {
+        //decimal exponent estimate from the binary one. Might be off by one, that's fixed below.
+        int binexponent;
+        frexp(absval,&binexponent);
+        int exponent=floor((binexponent-1)*0.30102999566398120);
+        int shift=precision-1-exponent;
+        double scaled = shift>=0 ? absval*powersoften[shift] : absval/powersoften[-shift];
+        if(scaled<powersoften[precision-1])
+        {
+            exponent--;
+            shift++;
+            scaled = shift>=0 ? absval*powersoften[shift] : absval/powersoften[-shift];
+        }
+        else if(scaled>=powersoften[precision])
+        {
+            exponent++;
+            shift--;
+            scaled = shift>=0 ? absval*powersoften[shift] : absval/powersoften[-shift];
+        }
+        //scaled carries a relative error of at most one rounding, that's far below 1e-6 absolute for 9 digits.
+        double integral=floor(scaled);
+        double fraction=scaled-integral;
+        if(fabs(fraction-0.5)>1e-6)
+        {
+            unsigned long digits=integral + (fraction>0.5 ? 1 : 0);
+            if(digits>=powersoften[precision])
+            {
+                //rounded up to the next power of ten
+                digits/=10;
+                exponent++;
+            }
+            char text[16];
+            for(int i=precision-1;i>=0;i--)
+            {
+                text[i]='0'+digits%10;
+                digits/=10;
+            }
+            //%g drops trailing zeros
+            int significant=precision;
+            while(significant>1 && text[significant-1]=='0')
+            {
+                significant--;
+            }
+            char *out=&buffer[used];
+            if(value<0)
+            {
+                *out++='-';
+            }
+            if(exponent<-4 || exponent>=precision)
+            {
+                *out++=text[0];
+                if(significant>1)
+                {
+                    *out++='.';
+                    memcpy(out,text+1,significant-1);
+                    out+=significant-1;
+                }
+                *out++='e';
+                *out++= exponent<0 ? '-' : '+';
+                int absexp=abs(exponent);
+                if(absexp>=100)
+                {
+                    *out++='0'+absexp/100;
+                }
+                *out++='0'+(absexp/10)%10;
+                *out++='0'+absexp%10;
+            }
+            else if(exponent<0)
+            {
+                *out++='0';
+                *out++='.';
+                for(int i=-1;i>exponent;i--)
+                {
+                    *out++='0';
+                }
+                memcpy(out,text,significant);
+                out+=significant;
+            }
+            else
+            {
+                memcpy(out,text,exponent+1);
+                out+=exponent+1;
+                if(significant>exponent+1)
+                {
+                    *out++='.';
+                    memcpy(out,text+exponent+1,significant-exponent-1);
+                    out+=significant-exponent-1;
+                }
+            }
+            used=out-&buffer[0];
+            return;
+        }
+    }
+    //zero, infinities, nan, huge or tiny numbers, and near-ties go the slow way.
+    char text[32];
+    int length=snprintf(text,sizeof(text),"%.*g",precision,value);
+    append(text,length);
+}
+
+void outbuffer::appendshortest(double value)
+{
+    char digits[24];
+    int length, exponent;
+    if(std::isfinite(value) && value!=0.0 && grisu3(fabs(value),digits,length,exponent))
+    {
+        //written the way the %.15g, %.16g or %.17g of the fallback would: the precision is that of the digits,
+        //but at least 15, and it decides between the plain and the exponential form, just like there.
+        const int precision=std::max(15,length);
+        const int decimal=exponent+length-1; //of the first digit
+        grow(length+32);
+        char *out=&buffer[used];
+        if(value<0)
+        {
+            *out++='-';
+        }
+        if(decimal<-4 || decimal>=precision)
+        {
+            *out++=digits[0];
+            if(length>1)
+            {
+                *out++='.';
+                memcpy(out,digits+1,length-1);
+                out+=length-1;
+            }
+            *out++='e';
+            *out++= decimal<0 ? '-' : '+';
+            const int absexp=abs(decimal);
+            if(absexp>=100)
+            {
+                *out++='0'+absexp/100;
+            }
+            *out++='0'+(absexp/10)%10;
+            *out++='0'+absexp%10;
+        }
+        else if(decimal<0)
+        {
+            *out++='0';
+            *out++='.';
+            for(int i=-1;i>decimal;i--)
+            {
+                *out++='0';
+            }
+            memcpy(out,digits,length);
+            out+=length;
+        }
+        else
+        {
+            for(int i=0;i<=decimal;i++)
+            {
+                *out++ = i<length ? digits[i] : '0';
+            }
+            if(length>decimal+1)
+            {
+                *out++='.';
+                memcpy(out,digits+decimal+1,length-decimal-1);
+                out+=length-decimal-1;
+            }
+        }
+        used=out-&buffer[0];
+        return;
+    }
+    //0, infinities and NaN, and the few values Grisu3 isn't sure about:
+    //the shortest of %.15g, %.16g, %.17g that reads back unchanged. 17 digits always do.
+    char text[32];
+    length=0;
+    for(int precision=15;precision<=17;precision++)
+    {
+        length=snprintf(text,sizeof(text),"%.*g",precision,value);
+        if(precision==17 || strtod(text,0)==value || std::isnan(value))
+        {
+            break;
+        }
+    }
+    append(text,length);
+}
+
+bool outbuffer::flush()
+{
+    if(fd<0)
+    {
+        return(true);
+    }
+    size_t done=0;
+    while(done<used)
+    {
+        //usually a single call. Loop only because pipes may accept less than asked for.
+        long written=write(fd,&buffer[done],used-done);
+        if(written<0 && errno==EINTR)
+        {
+            continue;
+        }
+        if(written<=0)
+        {
+            //a full disk or a closed pipe: what wasn't written stays, so a later flush can try again.
+            error = written<0 ? errno : EIO;
+            memmove(&buffer[0],&buffer[done],used-done);
+            used-=done;
+            return(false);
+        }
+        done+=written;
+    }
+    used=0;
+    return(true);
+}
+
+int outbuffer::geterror() const
+{
+    return(error);
+}
+
+void outbuffer::flushmaybe()
+{
+    if(used>threshold)
+    {
+        flush();
+    }
+}
+
+const char* outbuffer::data() const
+{
+    return(buffer.empty() ? 0 : &buffer[0]);
+}
+
+size_t outbuffer::size() const
+{
+    return(used);
+}
+
+void outbuffer::clear()
+{
+    used=0;
+}
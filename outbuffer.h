@@ -0,0 +1,80 @@
+/*
+ * LatticeMatch calculator - buffered output
+ * Copyright (C) 2015 Andreas Grois
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ *
+ * A large, reusable output buffer that is written to a file descriptor with a single write call per flush.
+ * It also does the number formatting, because iostreams are slow at that:
+ * o) appendg() gives exactly what printf's %g (and therefore cout's default formatting) would print,
+ *    but for the usual precisions it gets the digits with a single multiplication instead of going through
+ *    the locale machinery. Only if the result is too close to a rounding tie it asks snprintf.
+ * o) appendshortest() prints the shortest representation that reads back to the very same double.
+ *
+ * This class is part of the LatticeMatch program.
+ *
+ * To contact the author either use electronic mail: Andreas Grois <andreas.grois@jku.at>
+ * or write to:
+ * Andreas Grois, Institute for Semiconductor and SolidState physics, Johannes Kepler University,
+ * Altenbergerstraße 69, 4040 Linz, AUSTRIA
+ */
+
+#ifndef OUTBUFFER_H
+#define OUTBUFFER_H
+
+#include <vector>
+#include <cstddef>
+
+class outbuffer
+{
+private:
+    std::vector<char> buffer;
+    size_t used;
+    size_t threshold; //flushmaybe() flushes when more than this is in the buffer.
+    int fd;
+    int error; //errno of the last write that failed, 0 if none did.
+    void grow(size_t extra);
+public:
+    //fd 1 is stdout. capacity is the initial size of the buffer, it grows if a single item doesn't fit.
+    //A negative fd gives a buffer that only collects: flush() keeps everything, see data() and clear().
+    outbuffer(int fd=1, size_t capacity=1<<20);
+    ~outbuffer(); //flushes
+
+    void append(char c);
+    void append(const char *text);
+    void append(const char *data, size_t length);
+    void appendu(unsigned long long value);
+    //like printf("%.*g",precision,value)
+    void appendg(double value, int precision=6);
+    //shortest text that round-trips to value.
+    void appendshortest(double value);
+
+    //writes everything, and empties the buffer. Interrupted writes are retried. If writing fails, false is
+    //returned and what couldn't be written stays in the buffer, see geterror().
+    bool flush();
+    //the errno of the last write that failed, 0 if all went through so far.
+    int geterror() const;
+    //flushes if the buffer is filled above the threshold. Call this after each logical record.
+    void flushmaybe();
+
+    //what is in the buffer right now
+    const char* data() const;
+    size_t size() const;
+    //empties the buffer without writing anything
+    void clear();
+};
+
+#endif // OUTBUFFER_H
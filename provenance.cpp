@@ -0,0 +1,319 @@
+/*
+ * LatticeMatch calculator - which epitaxy matrices a match comes from
+ * Copyright (C) 2015 Andreas Grois
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ *
+ * See provenance.h.
+ *
+ * This class is part of the LatticeMatch program.
+ *
+ * To contact the author either use electronic mail: Andreas Grois <andreas.grois@jku.at>
+ * or write to:
+ * Andreas Grois, Institute for Semiconductor and SolidState physics, Johannes Kepler University,
+ * Altenbergerstraße 69, 4040 Linz, AUSTRIA
+ */
+
+#include "provenance.h"
+#include <cmath>
+#include <algorithm>
+#include <utility>
+#include <cstdlib>
+
+bool epitaxymatrix::operator<(const epitaxymatrix &other) const
+{
+    if(loop!=other.loop)
+        return(loop<other.loop);
+    if(px!=other.px)
+        return(px<other.px);
+    if(qx!=other.qx)
+        return(qx<other.qx);
+    if(qy!=other.qy)
+        return(qy<other.qy);
+    return(py<other.py);
+}
+
+bool epitaxymatrix::operator==(const epitaxymatrix &other) const
+{
+    return(loop==other.loop && px==other.px && qx==other.qx && qy==other.qy && py==other.py);
+}
+
+template<class interval> static bool bylower(const interval &a, const interval &b)
+{
+    return(a.lower<b.lower);
+}
+
+//calls found(x, y) for every x of a and y of b that have at least one angle in common. Sorts both.
+//Whichever of the two starts next is compared to the ones of the other side that are still open, opena and openb
+//keep track of them. They are only passed in so their storage can be reused.
+template<class first, class second, class callback> static void sweep(std::vector<first> &a, std::vector<second> &b, callback found,
+                                                                      std::vector<size_t> &opena, std::vector<size_t> &openb)
+{
+    std::sort(a.begin(),a.end(),bylower<first>);
+    std::sort(b.begin(),b.end(),bylower<second>);
+    opena.clear();
+    openb.clear();
+    size_t i=0, j=0;
+    while(i<a.size() || j<b.size())
+    {
+        if(j>=b.size() || (i<a.size() && a[i].lower<=b[j].lower))
+        {
+            const double start=a[i].lower;
+            //ranges that ended before this one starts won't overlap anything that comes later either.
+            openb.erase(std::remove_if(openb.begin(),openb.end(),[&](size_t k){ return(b[k].upper<start); }),openb.end());
+            for(size_t k : openb)
+            {
+                found(a[i],b[k]);
+            }
+            opena.push_back(i++);
+        }
+        else
+        {
+            const double start=b[j].lower;
+            opena.erase(std::remove_if(opena.begin(),opena.end(),[&](size_t k){ return(a[k].upper<start); }),opena.end());
+            for(size_t k : opena)
+            {
+                found(a[k],b[j]);
+            }
+            openb.push_back(j++);
+        }
+    }
+}
+
+provenance::provenance()
+{
+    valid=false;
+    maxdeterminant=0;
+}
+
+void provenance::setmaxdeterminant(unsigned int limit)
+{
+    maxdeterminant=limit;
+}
+
+void provenance::clear()
+{
+    xpieces.clear();
+    ypieces.clear();
+    bothpieces.clear();
+    coincidentoffsets.clear();
+    commensurateoffsets.clear();
+    coincidentlabels.clear();
+    commensuratelabels.clear();
+    valid=false;
+}
+
+void provenance::cut(const std::vector<anglerange> &ranges, const std::vector<int> &indices, int which, int loop, std::vector<piece> &pieces)
+{
+    for(size_t k=0;k<ranges.size() && k<indices.size();k++)
+    {
+        const anglerange &range=ranges[k];
+        if(range.isempty())
+        {
+            continue;
+        }
+        piece p;
+        p.matrix.loop=loop;
+        p.matrix.px = which==0 ? indices[k] : FREE;
+        p.matrix.qx = which==1 ? indices[k] : FREE;
+        p.matrix.qy = which==2 ? indices[k] : FREE;
+        p.matrix.py = which==3 ? indices[k] : FREE;
+        double lower=range.getlower().getval(), upper=range.getupper().getval();
+        if(range.iscircle())
+        {
+            lower=0.0;
+            upper=2*M_PI;
+        }
+        if(lower<=upper)
+        {
+            p.lower=lower;
+            p.upper=upper;
+            pieces.push_back(p);
+        }
+        else
+        {
+            p.lower=lower;
+            p.upper=2*M_PI;
+            pieces.push_back(p);
+            p.lower=0.0;
+            p.upper=upper;
+            pieces.push_back(p);
+        }
+    }
+}
+
+void provenance::overlaps(std::vector<piece> &a, std::vector<piece> &b, std::vector<piece> &result, unsigned int limit)
+{
+    sweep(a,b,[&](const piece &x, const piece &y)
+    {
+        if(limit>0)
+        {
+            //x has px and qx, y has qy and py. 64 bits, the product of two indices can exceed an int.
+            const long long determinant=static_cast<long long>(x.matrix.px)*y.matrix.py-static_cast<long long>(x.matrix.qx)*y.matrix.qy;
+            if(std::llabs(determinant)>limit)
+            {
+                return;
+            }
+        }
+        piece both;
+        both.lower=std::max(x.lower,y.lower);
+        both.upper=std::min(x.upper,y.upper);
+        both.matrix.loop=x.matrix.loop;
+        both.matrix.px = x.matrix.px!=FREE ? x.matrix.px : y.matrix.px;
+        both.matrix.qx = x.matrix.qx!=FREE ? x.matrix.qx : y.matrix.qx;
+        both.matrix.qy = x.matrix.qy!=FREE ? x.matrix.qy : y.matrix.qy;
+        both.matrix.py = x.matrix.py!=FREE ? x.matrix.py : y.matrix.py;
+        result.push_back(both);
+    },opena,openb);
+}
+
+void provenance::addloop(int loop, const std::vector<anglerange> &px, const std::vector<int> &pxindices,
+                         const std::vector<anglerange> &qx, const std::vector<int> &qxindices,
+                         const std::vector<anglerange> &qy, const std::vector<int> &qyindices,
+                         const std::vector<anglerange> &py, const std::vector<int> &pyindices)
+{
+    //members, so a solver that is used again and again doesn't allocate them anew.
+    first.clear();
+    second.clear();
+    x.clear();
+    y.clear();
+    cut(px,pxindices,0,loop,first);
+    cut(qx,qxindices,1,loop,second);
+    overlaps(first,second,x);
+    first.clear();
+    second.clear();
+    cut(qy,qyindices,2,loop,first);
+    cut(py,pyindices,3,loop,second);
+    overlaps(first,second,y);
+    //commensurate only within one loop, the two runs of a hexagonal substrate are separate solutions.
+    overlaps(x,y,bothpieces,maxdeterminant);
+    xpieces.insert(xpieces.end(),x.begin(),x.end());
+    ypieces.insert(ypieces.end(),y.begin(),y.end());
+}
+
+void provenance::addcommensurate(angleset &target)
+{
+    //there can be far more pieces than ranges, so they are joined up here in one go, not by the set.
+    std::vector<std::pair<double,double> > &pieces=joined;
+    pieces.clear();
+    pieces.reserve(bothpieces.size());
+    for(std::vector<piece>::const_iterator i=bothpieces.begin();i!=bothpieces.end();++i)
+    {
+        pieces.push_back(std::make_pair(i->lower,i->upper));
+    }
+    std::sort(pieces.begin(),pieces.end());
+    for(size_t k=0;k<pieces.size();)
+    {
+        const double lower=pieces[k].first;
+        double upper=pieces[k].second;
+        for(k++;k<pieces.size() && pieces[k].first<=upper;k++)
+        {
+            upper=std::max(upper,pieces[k].second);
+        }
+        target.append(anglerange(lower,upper));
+    }
+}
+
+void provenance::assign(std::vector<piece> &pieces, angleset &results, std::vector<size_t> &offsets, std::vector<epitaxymatrix> &labels)
+{
+    std::vector<target> targets;
+    const std::vector<anglerange> &ranges=results.getrangesref();
+    for(size_t k=0;k<ranges.size();k++)
+    {
+        target t;
+        t.index=k;
+        double lower=ranges[k].getlower().getval(), upper=ranges[k].getupper().getval();
+        if(ranges[k].iscircle())
+        {
+            lower=0.0;
+            upper=2*M_PI;
+        }
+        if(lower<=upper)
+        {
+            t.lower=lower;
+            t.upper=upper;
+            targets.push_back(t);
+        }
+        else
+        {
+            t.lower=lower;
+            t.upper=2*M_PI;
+            targets.push_back(t);
+            t.lower=0.0;
+            t.upper=upper;
+            targets.push_back(t);
+        }
+    }
+    //pieces that were pruned away don't touch any result, and simply don't show up.
+    std::vector<std::pair<size_t,epitaxymatrix> > hits;
+    std::vector<size_t> opena, openb;
+    sweep(pieces,targets,[&](const piece &p, const target &t){ hits.push_back(std::make_pair(t.index,p.matrix)); },opena,openb);
+    std::sort(hits.begin(),hits.end(),[](const std::pair<size_t,epitaxymatrix> &a, const std::pair<size_t,epitaxymatrix> &b)
+    {
+        return(a.first<b.first || (a.first==b.first && a.second<b.second));
+    });
+    hits.erase(std::unique(hits.begin(),hits.end()),hits.end());
+    offsets.assign(ranges.size()+1,0);
+    labels.clear();
+    labels.reserve(hits.size());
+    for(size_t k=0;k<hits.size();k++)
+    {
+        offsets[hits[k].first+1]++;
+        labels.push_back(hits[k].second);
+    }
+    for(size_t k=0;k<ranges.size();k++)
+    {
+        offsets[k+1]+=offsets[k];
+    }
+    pieces.clear();
+    pieces.shrink_to_fit();
+}
+
+void provenance::assign(angleset &coincident, angleset &commensurate)
+{
+    xpieces.insert(xpieces.end(),ypieces.begin(),ypieces.end());
+    ypieces.clear();
+    ypieces.shrink_to_fit();
+    assign(xpieces,coincident,coincidentoffsets,coincidentlabels);
+    assign(bothpieces,commensurate,commensurateoffsets,commensuratelabels);
+    valid=true;
+}
+
+bool provenance::isvalid() const
+{
+    return(valid);
+}
+
+size_t provenance::count(bool commensurate, size_t k) const
+{
+    const std::vector<size_t> &offsets = commensurate ? commensurateoffsets : coincidentoffsets;
+    if(k+1>=offsets.size())
+    {
+        return(0);
+    }
+    return(offsets[k+1]-offsets[k]);
+}
+
+const epitaxymatrix* provenance::labels(bool commensurate, size_t k) const
+{
+    const std::vector<size_t> &offsets = commensurate ? commensurateoffsets : coincidentoffsets;
+    const std::vector<epitaxymatrix> &labels = commensurate ? commensuratelabels : coincidentlabels;
+    if(k+1>=offsets.size() || offsets[k]==offsets[k+1])
+    {
+        return(0);
+    }
+    return(&labels[offsets[k]]);
+}
@@ -0,0 +1,122 @@
+/*
+ * LatticeMatch calculator - which epitaxy matrices a match comes from
+ * Copyright (C) 2015 Andreas Grois
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ *
+ * The solver only keeps angles: once a family is consolidated, nobody knows any more which index gave which
+ * range. This class keeps that information on the side. It gets the four families of each loop as they were
+ * generated, one label per range, and does the overlaps once more, pairwise this time: every px range of
+ * index n that overlaps a qx range of index m gives a piece labelled (n, m), and so on. At the end the pieces
+ * are mapped onto the consolidated results, so every result range gets the list of epitaxy matrices
+ *   ( px qy )
+ *   ( qx py )
+ * whose ranges make it up. For coincident matches only one column is fixed, the other entries are FREE.
+ *
+ * Ranges going through 0 are cut in two, so the pairwise overlaps are plain interval overlaps, found by a
+ * sweep over both sides sorted by their lower borders. The cost is proportional to the number of overlapping
+ * pairs, which is what the labels are made of anyhow.
+ *
+ * With a largest determinant set, commensurate pieces whose matrix has a larger |px*py-qx*qy| are not even made,
+ * and addcommensurate() gives what is left of them: the matches with at most that many substrate cells in the
+ * supercell.
+ *
+ * Matrices from the second run of a hexagonal substrate have loop set to 1. They refer to the substrate cell
+ * with a2 turned by another 60 degrees (alpha+60), which is a different basis of the same lattice.
+ *
+ * This class is part of the LatticeMatch program.
+ *
+ * To contact the author either use electronic mail: Andreas Grois <andreas.grois@jku.at>
+ * or write to:
+ * Andreas Grois, Institute for Semiconductor and SolidState physics, Johannes Kepler University,
+ * Altenbergerstraße 69, 4040 Linz, AUSTRIA
+ */
+
+#ifndef PROVENANCE_H
+#define PROVENANCE_H
+
+#include <vector>
+#include <climits>
+#include <utility>
+#include "angleset.h"
+
+struct epitaxymatrix
+{
+    int px, qx, qy, py;
+    int loop;
+    bool operator<(const epitaxymatrix &other) const;
+    bool operator==(const epitaxymatrix &other) const;
+};
+
+class provenance
+{
+public:
+    //an entry the match doesn't fix.
+    static const int FREE=INT_MIN;
+private:
+    //a range that doesn't go through 0, and where it comes from.
+    struct piece
+    {
+        double lower, upper;
+        epitaxymatrix matrix;
+    };
+    //a result range, or half of one.
+    struct target
+    {
+        double lower, upper;
+        size_t index;
+    };
+    std::vector<piece> xpieces, ypieces, bothpieces;
+    //the labels of result range k are labels[offsets[k]] up to labels[offsets[k+1]], sorted.
+    std::vector<size_t> coincidentoffsets, commensurateoffsets;
+    std::vector<epitaxymatrix> coincidentlabels, commensuratelabels;
+    bool valid;
+    unsigned int maxdeterminant; //0: no limit
+    //scratch of addloop(), overlaps() and addcommensurate(), kept from one solve to the next.
+    std::vector<piece> first, second, x, y;
+    std::vector<size_t> opena, openb;
+    std::vector<std::pair<double,double> > joined;
+
+    //which: 0 px, 1 qx, 2 qy, 3 py.
+    static void cut(const std::vector<anglerange> &ranges, const std::vector<int> &indices, int which, int loop, std::vector<piece> &pieces);
+    //only pieces whose matrix has |determinant|<=limit are kept, if that isn't 0. Then a has to be the
+    //x pieces, b the y pieces.
+    void overlaps(std::vector<piece> &a, std::vector<piece> &b, std::vector<piece> &result, unsigned int limit=0);
+    static void assign(std::vector<piece> &pieces, angleset &results, std::vector<size_t> &offsets, std::vector<epitaxymatrix> &labels);
+public:
+    provenance();
+    void clear();
+    //commensurate matrices with a larger |px*py-qx*qy| are left out from the next addloop() on. 0, the default, keeps
+    //them all. Not changed by clear().
+    void setmaxdeterminant(unsigned int limit);
+    //the families of one loop as they were generated, before any consolidation, and the index of each range.
+    void addloop(int loop, const std::vector<anglerange> &px, const std::vector<int> &pxindices,
+                 const std::vector<anglerange> &qx, const std::vector<int> &qxindices,
+                 const std::vector<anglerange> &qy, const std::vector<int> &qyindices,
+                 const std::vector<anglerange> &py, const std::vector<int> &pyindices);
+    //the commensurate pieces of all loops so far, joined up and sorted, into target, which has to be empty. Ranges
+    //through 0 come as two. Must come before assign(), which drops the pieces.
+    void addcommensurate(angleset &target);
+    //after all loops: hands the pieces out to the consolidated and sorted results, and drops them.
+    void assign(angleset &coincident, angleset &commensurate);
+    //false if nothing has been assigned since the last clear().
+    bool isvalid() const;
+    //the matrices of result range k, in the order of getrangesref(), sorted, each only once.
+    size_t count(bool commensurate, size_t k) const;
+    const epitaxymatrix* labels(bool commensurate, size_t k) const;
+};
+
+#endif // PROVENANCE_H
@@ -0,0 +1,67 @@
+/*
+ * LatticeMatch calculator - pulling results from the solver
+ * Copyright (C) 2015 Andreas Grois
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ *
+ * See rangeiterator.h.
+ *
+ * This class is part of the LatticeMatch program.
+ *
+ * To contact the author either use electronic mail: Andreas Grois <andreas.grois@jku.at>
+ * or write to:
+ * Andreas Grois, Institute for Semiconductor and SolidState physics, Johannes Kepler University,
+ * Altenbergerstraße 69, 4040 Linz, AUSTRIA
+ */
+
+#include "rangeiterator.h"
+
+rangeiterator::rangeiterator(matchsolver &solver, double start, unsigned int sectors) : solver(solver)
+{
+    this->start=start;
+    this->sectors=sectors;
+    started=false;
+}
+
+bool rangeiterator::next(match &target)
+{
+    if(!started)
+    {
+        solver.startsweep(sectors,start,this,false);
+        started=true;
+    }
+    //a sector may well give nothing final, e.g. if a range goes on across several of them.
+    while(ready.empty() && solver.sweepstep());
+    if(ready.empty())
+    {
+        return(false);
+    }
+    target=ready.front();
+    ready.pop_front();
+    return(true);
+}
+
+void rangeiterator::writefinalrange(bool commensurate, const anglerange &range)
+{
+    match found;
+    found.commensurate=commensurate;
+    found.range=range;
+    ready.push_back(found);
+}
+
+void rangeiterator::writesectordone()
+{
+}
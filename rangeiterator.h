@@ -0,0 +1,70 @@
+/*
+ * LatticeMatch calculator - pulling results from the solver
+ * Copyright (C) 2015 Andreas Grois
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ *
+ * Pull-based access to the results of a matchsolver: next() hands out one final range after the other, in
+ * angular order, and only solves as many sectors as it takes to have the next one ready. Someone who only
+ * wants the first few matches after some angle, or stops after finding what they need, doesn't pay for the
+ * rest of the circle. Generating the four families is cheap and done up front, it's the overlaps that are
+ * done sector by sector, on demand.
+ *
+ * The ranges of each set come in ascending order starting at the start angle, coincident and commensurate
+ * ones interleaved as they become final. A range that starts exactly at the start angle comes last, as it
+ * may join up with one that goes all around the circle. Ranges crossing the start angle come last too.
+ *
+ * This class is part of the LatticeMatch program.
+ *
+ * To contact the author either use electronic mail: Andreas Grois <andreas.grois@jku.at>
+ * or write to:
+ * Andreas Grois, Institute for Semiconductor and SolidState physics, Johannes Kepler University,
+ * Altenbergerstraße 69, 4040 Linz, AUSTRIA
+ */
+
+#ifndef RANGEITERATOR_H
+#define RANGEITERATOR_H
+
+#include <deque>
+#include "matchsolver.h"
+
+class rangeiterator : private matchsink
+{
+public:
+    struct match
+    {
+        bool commensurate;
+        anglerange range;
+    };
+private:
+    matchsolver &solver;
+    double start;
+    unsigned int sectors;
+    bool started;
+    std::deque<match> ready; //final, but not handed out yet
+
+    void writefinalrange(bool commensurate, const anglerange &range);
+    void writesectordone();
+public:
+    //nothing is calculated before the first next(). The solver must not be used for anything else until
+    //next() returned false, afterwards it counts as not solved. start is in radians.
+    rangeiterator(matchsolver &solver, double start=0.0, unsigned int sectors=64);
+
+    //the next range, false if there are no more.
+    bool next(match &target);
+};
+
+#endif // RANGEITERATOR_H
@@ -0,0 +1,62 @@
+/*
+ * LatticeMatch calculator - scores for ranges
+ * Copyright (C) 2015 Andreas Grois
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ *
+ * How good a range of matches is, for picking the best ones (see rangeselector). Higher is better.
+ * The plain choice is the width: a wide range tolerates a badly aligned sample. The other one is how close
+ * the best angle inside the range gets the epitaxy matrix to integers, see bestangle.h.
+ *
+ * This class is part of the LatticeMatch program.
+ *
+ * To contact the author either use electronic mail: Andreas Grois <andreas.grois@jku.at>
+ * or write to:
+ * Andreas Grois, Institute for Semiconductor and SolidState physics, Johannes Kepler University,
+ * Altenbergerstraße 69, 4040 Linz, AUSTRIA
+ */
+
+#ifndef RANGESCORE_H
+#define RANGESCORE_H
+
+#include "anglerange.h"
+#include "bestangle.h"
+
+class rangescore
+{
+public:
+    virtual ~rangescore();
+    virtual double score(const anglerange &range, bool commensurate) const=0;
+};
+
+//anglerange::getsize()
+class widthscore : public rangescore
+{
+public:
+    double score(const anglerange &range, bool commensurate) const;
+};
+
+//minus the misfit at the best angle. Belongs to one set of parameters, as bestangle does.
+class misfitscore : public rangescore
+{
+private:
+    bestangle fitter;
+public:
+    misfitscore(const double input[9], int loops);
+    double score(const anglerange &range, bool commensurate) const;
+};
+
+#endif // RANGESCORE_H
@@ -0,0 +1,85 @@
+/*
+ * LatticeMatch calculator - picking the best ranges
+ * Copyright (C) 2015 Andreas Grois
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ *
+ * See rangeselector.h.
+ *
+ * This class is part of the LatticeMatch program.
+ *
+ * To contact the author either use electronic mail: Andreas Grois <andreas.grois@jku.at>
+ * or write to:
+ * Andreas Grois, Institute for Semiconductor and SolidState physics, Johannes Kepler University,
+ * Altenbergerstraße 69, 4040 Linz, AUSTRIA
+ */
+
+#include "rangeselector.h"
+#include <algorithm>
+
+rangeselector::rangeselector(unsigned int k, const rangescore &scorer) : scorer(scorer)
+{
+    this->k=k;
+    heaps[0].reserve(k+1);
+    heaps[1].reserve(k+1);
+}
+
+bool rangeselector::better(const scoredrange &a, const scoredrange &b)
+{
+    //as heap comparison this gives a min-heap, with the worst range on top.
+    return(a.score>b.score);
+}
+
+void rangeselector::writefinalrange(bool commensurate, const anglerange &range)
+{
+    if(k==0)
+    {
+        return;
+    }
+    std::vector<scoredrange> &heap=heaps[commensurate ? 1 : 0];
+    scoredrange candidate;
+    candidate.score=scorer.score(range,commensurate);
+    candidate.range=range;
+    if(heap.size()<k)
+    {
+        heap.push_back(candidate);
+        std::push_heap(heap.begin(),heap.end(),better);
+    }
+    else if(better(candidate,heap.front()))
+    {
+        std::pop_heap(heap.begin(),heap.end(),better);
+        heap.back()=candidate;
+        std::push_heap(heap.begin(),heap.end(),better);
+    }
+}
+
+void rangeselector::writesectordone()
+{
+}
+
+std::vector<rangeselector::scoredrange> rangeselector::getbest(bool commensurate) const
+{
+    std::vector<scoredrange> best=heaps[commensurate ? 1 : 0];
+    //only k of them, so this is cheap.
+    std::sort_heap(best.begin(),best.end(),better);
+    return(best);
+}
+
+void rangeselector::clear()
+{
+    heaps[0].clear();
+    heaps[1].clear();
+}
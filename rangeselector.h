@@ -0,0 +1,66 @@
+/*
+ * LatticeMatch calculator - picking the best ranges
+ * Copyright (C) 2015 Andreas Grois
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ *
+ * Keeps the k best ranges of each result set, by a rangescore, while the solver hands them over one after the
+ * other (it's a matchsink, see matchsolver::solvetop). Every set has a bounded min-heap of size k: a new range
+ * only goes in if it beats the worst one kept, which then gets dropped. So the cost is O(log k) per range,
+ * the memory is O(k), and the ranges that don't make it are neither sorted nor kept.
+ *
+ * This class is part of the LatticeMatch program.
+ *
+ * To contact the author either use electronic mail: Andreas Grois <andreas.grois@jku.at>
+ * or write to:
+ * Andreas Grois, Institute for Semiconductor and SolidState physics, Johannes Kepler University,
+ * Altenbergerstraße 69, 4040 Linz, AUSTRIA
+ */
+
+#ifndef RANGESELECTOR_H
+#define RANGESELECTOR_H
+
+#include <vector>
+#include "matchsolver.h"
+#include "rangescore.h"
+
+class rangeselector : public matchsink
+{
+public:
+    struct scoredrange
+    {
+        double score;
+        anglerange range;
+    };
+private:
+    unsigned int k;
+    const rangescore &scorer;
+    std::vector<scoredrange> heaps[2]; //coincident, commensurate. The worst kept range is at the front.
+    static bool better(const scoredrange &a, const scoredrange &b);
+public:
+    //scorer is not copied, it has to outlive the selector.
+    rangeselector(unsigned int k, const rangescore &scorer);
+
+    void writefinalrange(bool commensurate, const anglerange &range);
+    void writesectordone();
+
+    //the kept ranges of one set, best first.
+    std::vector<scoredrange> getbest(bool commensurate) const;
+    //empties both heaps, for the next solve.
+    void clear();
+};
+
+#endif // RANGESELECTOR_H
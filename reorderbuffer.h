@@ -0,0 +1,96 @@
+/*
+ * LatticeMatch calculator - putting parallel results back in order
+ * Copyright (C) 2015 Andreas Grois
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ *
+ * Sits between worker threads that solve numbered items in whatever order they finish, and the one thread
+ * that writes the results, in order. There is a fixed ring of slots: item i goes to slot i%size, and a worker
+ * may only start filling it once item i-size has been written. So at most size results are held at any time,
+ * and if the writer is slow (a slow disk, a full pipe) the workers simply wait for it, instead of piling up
+ * results in memory.
+ *
+ * The slots are filled and read without holding the lock, it's only taken to hand a slot over, which happens
+ * once per item. The items are whole solves, so that's not where the time goes.
+ *
+ * This class is part of the LatticeMatch program.
+ *
+ * To contact the author either use electronic mail: Andreas Grois <andreas.grois@jku.at>
+ * or write to:
+ * Andreas Grois, Institute for Semiconductor and SolidState physics, Johannes Kepler University,
+ * Altenbergerstraße 69, 4040 Linz, AUSTRIA
+ */
+
+#ifndef REORDERBUFFER_H
+#define REORDERBUFFER_H
+
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+
+template<class slotdata> class reorderbuffer
+{
+private:
+    std::vector<slotdata> slots;
+    std::vector<bool> filled;
+    unsigned long written; //items before this one are written, their slots are free again
+    std::mutex lock;
+    std::condition_variable slotfree;
+    std::condition_variable slotfilled;
+public:
+    //every slot starts out as a copy of prototype, and keeps what the last item left in it.
+    reorderbuffer(size_t size, const slotdata &prototype) : slots(size>0 ? size : 1,prototype), filled(slots.size(),false)
+    {
+        written=0;
+    }
+
+    //workers: waits until item index may be filled, and returns its slot.
+    slotdata& acquire(unsigned long index)
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        slotfree.wait(guard,[&]{ return(index<written+slots.size()); });
+        return(slots[index%slots.size()]);
+    }
+    //workers: item index is done.
+    void publish(unsigned long index)
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            filled[index%slots.size()]=true;
+        }
+        slotfilled.notify_one();
+    }
+
+    //writer: waits for the next item in order, and returns its slot.
+    slotdata& next()
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        slotfilled.wait(guard,[&]{ return(bool(filled[written%slots.size()])); });
+        return(slots[written%slots.size()]);
+    }
+    //writer: the item returned by next() is written, its slot can be reused.
+    void release()
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            filled[written%slots.size()]=false;
+            written++;
+        }
+        slotfree.notify_all();
+    }
+};
+
+#endif // REORDERBUFFER_H
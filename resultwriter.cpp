@@ -0,0 +1,52 @@
+/*
+ * LatticeMatch calculator - interface for result output
+ * Copyright (C) 2015 Andreas Grois
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ *
+ * Base class for everything that writes results somewhere. main() doesn't care about the format,
+ * it just tells the writer what it's about to get (a batch entry, an extension, a sweep point), and then hands over
+ * the solver.
+ *
+ * This class is part of the LatticeMatch program.
+ *
+ * To contact the author either use electronic mail: Andreas Grois <andreas.grois@jku.at>
+ * or write to:
+ * Andreas Grois, Institute for Semiconductor and SolidState physics, Johannes Kepler University,
+ * Altenbergerstraße 69, 4040 Linz, AUSTRIA
+ */
+
+#include "resultwriter.h"
+#include <stdexcept>
+
+resultwriter::~resultwriter()
+{
+}
+
+void resultwriter::writeexists(matchsolver &, bool)
+{
+    throw std::logic_error("This output format cannot hold query answers.\n");
+}
+
+void resultwriter::writecount(matchsolver &, unsigned long)
+{
+    throw std::logic_error("This output format cannot hold query answers.\n");
+}
+
+void resultwriter::finish()
+{
+    flush();
+}
@@ -0,0 +1,63 @@
+/*
+ * LatticeMatch calculator - interface for result output
+ * Copyright (C) 2015 Andreas Grois
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ *
+ * Base class for everything that writes results somewhere. main() doesn't care about the format,
+ * it just tells the writer what it's about to get (a batch entry, an extension, a sweep point), and then hands over
+ * the solver.
+ *
+ * This class is part of the LatticeMatch program.
+ *
+ * To contact the author either use electronic mail: Andreas Grois <andreas.grois@jku.at>
+ * or write to:
+ * Andreas Grois, Institute for Semiconductor and SolidState physics, Johannes Kepler University,
+ * Altenbergerstraße 69, 4040 Linz, AUSTRIA
+ */
+
+#ifndef RESULTWRITER_H
+#define RESULTWRITER_H
+
+#include "matchsolver.h"
+
+class resultwriter
+{
+public:
+    virtual ~resultwriter();
+
+    //announce that the following results belong to an extended window
+    virtual void writeextension(double b1max, double b2max)=0;
+    //announce that the following results belong to a point of a sweep
+    virtual void writesweeppoint(unsigned int index, double b1min, double b1max)=0;
+    //announce that the following results only cover indices up to maxindex (see matchsolver::refine).
+    //complete is true if that's all the indices the window allows.
+    virtual void writeshell(unsigned int maxindex, bool complete)=0;
+    //announce that the following results belong to an entry of a batch file
+    virtual void writebatchentry(unsigned int index)=0;
+    //the results of a solve. The solver is not const, because getting the ranges might consolidate them.
+    virtual void writeresults(matchsolver &solver)=0;
+    //the answers of the query modes (see matchsolver::findcommensurate and countcommensurate), instead of results.
+    //Not every format can hold them, the default throws std::logic_error.
+    virtual void writeexists(matchsolver &solver, bool exists);
+    virtual void writecount(matchsolver &solver, unsigned long count);
+    //make sure everything is out.
+    virtual void flush()=0;
+    //called once after the last result. Formats with a trailer write it here, the others just flush.
+    virtual void finish();
+};
+
+#endif // RESULTWRITER_H
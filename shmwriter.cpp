@@ -0,0 +1,181 @@
+/*
+ * LatticeMatch calculator - publishing results in shared memory
+ * Copyright (C) 2015 Andreas Grois
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ *
+ * The records are put together by a binarywriter into a buffer, and copied into the ring from there.
+ * See shmwriter.h for the layout and the protocol.
+ *
+ * This class is part of the LatticeMatch program.
+ *
+ * To contact the author either use electronic mail: Andreas Grois <andreas.grois@jku.at>
+ * or write to:
+ * Andreas Grois, Institute for Semiconductor and SolidState physics, Johannes Kepler University,
+ * Altenbergerstraße 69, 4040 Linz, AUSTRIA
+ */
+
+#include "shmwriter.h"
+#include <cstring>
+#include <atomic>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+static_assert(sizeof(shmheader)==64,"shmheader has to be exactly 64 bytes, the layout depends on it.");
+static_assert(sizeof(shmslot)==16,"shmslot has to be exactly 16 bytes, the layout depends on it.");
+
+shmwriter::shmwriter(const char *name, uint32_t slotcount, uint32_t slotsize, bool binaryangles) : record(-1,1<<16), format(record,binaryangles)
+{
+    this->slotcount = slotcount>0 ? slotcount : 1;
+    this->slotsize = std::max<uint32_t>((slotsize+7)&~7u,sizeof(shmslot)+sizeof(binaryheader));
+    published=0;
+    memory=0;
+    mappedsize=sizeof(shmheader)+static_cast<size_t>(this->slotcount)*this->slotsize;
+    int fd=shm_open(name,O_CREAT|O_RDWR,0644);
+    if(fd<0)
+    {
+        return;
+    }
+    if(ftruncate(fd,mappedsize)!=0)
+    {
+        close(fd);
+        return;
+    }
+    void *mapped=mmap(0,mappedsize,PROT_READ|PROT_WRITE,MAP_SHARED,fd,0);
+    close(fd);
+    if(mapped==MAP_FAILED)
+    {
+        return;
+    }
+    memory=static_cast<char*>(mapped);
+    //an object that is reused may still hold old records. All sequences 0: nothing there.
+    memset(memory,0,mappedsize);
+    shmheader *header=reinterpret_cast<shmheader*>(memory);
+    header->version=1;
+    header->headersize=sizeof(shmheader);
+    header->slotcount=this->slotcount;
+    header->slotsize=this->slotsize;
+    //the magic last, so a reader that sees it sees the rest as well.
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(header->magic,"LATSHM01",8);
+}
+
+shmwriter::~shmwriter()
+{
+    if(memory)
+    {
+        munmap(memory,mappedsize);
+    }
+}
+
+bool shmwriter::isopen() const
+{
+    return(memory!=0);
+}
+
+void shmwriter::publish()
+{
+    const char *data=record.data();
+    binaryheader header;
+    memcpy(&header,data,sizeof(header));
+    size_t pairsize = (header.flags&BIN_ANGLES) ? 2*sizeof(uint32_t) : 2*sizeof(double);
+    uint64_t coincidentkept=header.coincidentcount, commensuratekept=header.commensuratecount;
+    size_t room=slotsize-sizeof(shmslot);
+    if(record.size()>room)
+    {
+        //only records with ranges can get this large, a query answer is just the header.
+        uint64_t pairs=(room-sizeof(header))/pairsize;
+        coincidentkept=std::min<uint64_t>(header.coincidentcount,pairs);
+        commensuratekept=std::min<uint64_t>(header.commensuratecount,pairs-coincidentkept);
+        header.flags|=BIN_TRUNCATED;
+        header.recordsize=sizeof(header)+(coincidentkept+commensuratekept)*pairsize;
+        header.recordsize+=(8-header.recordsize%8)%8;
+    }
+    const char *coincident=data+sizeof(header);
+    const char *commensurate=coincident+header.coincidentcount*pairsize;
+    header.coincidentcount=coincidentkept;
+    header.commensuratecount = (header.flags&BIN_QUERY) ? header.commensuratecount : commensuratekept;
+
+    char *slot=memory+sizeof(shmheader)+(published%slotcount)*static_cast<size_t>(slotsize);
+    shmslot *slotheader=reinterpret_cast<shmslot*>(slot);
+    char *target=slot+sizeof(shmslot);
+    __atomic_store_n(&slotheader->sequence,2*published+1,__ATOMIC_RELAXED);
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(target,&header,sizeof(header));
+    target+=sizeof(header);
+    if(!(header.flags&BIN_QUERY))
+    {
+        memcpy(target,coincident,coincidentkept*pairsize);
+        target+=coincidentkept*pairsize;
+        memcpy(target,commensurate,commensuratekept*pairsize);
+        target+=commensuratekept*pairsize;
+    }
+    memset(target,0,slot+sizeof(shmslot)+header.recordsize-target);
+    __atomic_store_n(&slotheader->sequence,2*published+2,__ATOMIC_RELEASE);
+    published++;
+    __atomic_store_n(&reinterpret_cast<shmheader*>(memory)->published,published,__ATOMIC_RELEASE);
+    record.clear();
+}
+
+void shmwriter::writeextension(double b1max, double b2max)
+{
+    format.writeextension(b1max,b2max);
+}
+
+void shmwriter::writesweeppoint(unsigned int index, double b1min, double b1max)
+{
+    format.writesweeppoint(index,b1min,b1max);
+}
+
+void shmwriter::writeshell(unsigned int maxindex, bool complete)
+{
+    format.writeshell(maxindex,complete);
+}
+
+void shmwriter::writebatchentry(unsigned int index)
+{
+    format.writebatchentry(index);
+}
+
+void shmwriter::writeresults(matchsolver &solver)
+{
+    format.writeresults(solver);
+    publish();
+}
+
+void shmwriter::writeexists(matchsolver &solver, bool exists)
+{
+    format.writeexists(solver,exists);
+    publish();
+}
+
+void shmwriter::writecount(matchsolver &solver, unsigned long count)
+{
+    format.writecount(solver,count);
+    publish();
+}
+
+void shmwriter::flush()
+{
+    //every record is out as soon as it's published.
+}
+
+void shmwriter::finish()
+{
+    __atomic_store_n(&reinterpret_cast<shmheader*>(memory)->finished,1u,__ATOMIC_RELEASE);
+}
@@ -0,0 +1,111 @@
+/*
+ * LatticeMatch calculator - publishing results in shared memory
+ * Copyright (C) 2015 Andreas Grois
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ *
+ * Publishes every record into a ring buffer in a POSIX shared memory object, for programs on the same machine
+ * that want the results as they come, without pipes, files or parsing. The records are the very same as in
+ * the binary format (see binarywriter.h), so consumers can cast them just the same.
+ *
+ * Layout of the shared memory object:
+ * o) a shmheader (64 bytes, see below)
+ * o) slotcount slots of slotsize bytes each. A slot is a shmslot (16 bytes), followed by one record.
+ * Record n (counting from 0) goes into slot n%slotcount, so the last slotcount records are available.
+ *
+ * Protocol, one writer and any number of readers, readers never write:
+ * o) the writer sets the sequence of the slot to 2n+1 (odd: being written), copies record n in, sets the
+ *    sequence to 2n+2, and then sets published to n+1. Both with release semantics.
+ * o) a reader that wants record n loads the sequence of its slot (acquire). 2n+2 means the record is there,
+ *    less means not yet, more means it has been overwritten already. It then copies the record out, and
+ *    loads the sequence again (after an acquire fence): if it changed, the copy is garbage, the reader has
+ *    fallen behind by a whole ring and should continue at published-slotcount.
+ * o) published says how many records there are, finished is set to 1 once the last one is published.
+ * The writer never waits for readers: a slow reader loses records, the solver is never held up.
+ *
+ * A record larger than a slot is cut: BIN_TRUNCATED is set, and the counts and recordsize in its header say
+ * what's left (the coincident ranges come first).
+ *
+ * The object is created (or reused and reset) by the writer, and left in place afterwards for the readers.
+ * Removing it is up to them: shm_unlink(), or on Linux deleting it from /dev/shm.
+ * Everything is in the byte order of the machine, which is the only one that can see it.
+ *
+ * This class is part of the LatticeMatch program.
+ *
+ * To contact the author either use electronic mail: Andreas Grois <andreas.grois@jku.at>
+ * or write to:
+ * Andreas Grois, Institute for Semiconductor and SolidState physics, Johannes Kepler University,
+ * Altenbergerstraße 69, 4040 Linz, AUSTRIA
+ */
+
+#ifndef SHMWRITER_H
+#define SHMWRITER_H
+
+#include <stdint.h>
+#include "resultwriter.h"
+#include "outbuffer.h"
+#include "binarywriter.h"
+
+struct shmheader
+{
+    char magic[8];      //"LATSHM01"
+    uint32_t version;   //1
+    uint32_t headersize;//sizeof(shmheader), 64
+    uint32_t slotcount;
+    uint32_t slotsize;  //in bytes, including the shmslot, a multiple of 8
+    uint64_t published; //number of records published so far
+    uint32_t finished;  //1 once no more records will come
+    uint32_t reserved[7];
+};
+
+struct shmslot
+{
+    uint64_t sequence;  //2n+1 while record n is written, 2n+2 when it's complete
+    uint64_t reserved;
+};
+
+class shmwriter : public resultwriter
+{
+private:
+    outbuffer record; //collects one record, as the binary format has it
+    binarywriter format;
+    char *memory;
+    size_t mappedsize;
+    uint32_t slotcount;
+    uint32_t slotsize;
+    uint64_t published;
+    //copies the record collected so far into the next slot.
+    void publish();
+public:
+    //slotsize is rounded up to a multiple of 8, and is at least large enough for a record without ranges.
+    shmwriter(const char *name, uint32_t slotcount, uint32_t slotsize, bool binaryangles=false);
+    ~shmwriter();
+    //false if the shared memory object could not be created.
+    bool isopen() const;
+
+    void writeextension(double b1max, double b2max);
+    void writesweeppoint(unsigned int index, double b1min, double b1max);
+    void writeshell(unsigned int maxindex, bool complete);
+    void writebatchentry(unsigned int index);
+    void writeresults(matchsolver &solver);
+    void writeexists(matchsolver &solver, bool exists);
+    void writecount(matchsolver &solver, unsigned long count);
+    void flush();
+    //sets finished.
+    void finish();
+};
+
+#endif // SHMWRITER_H
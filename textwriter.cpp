@@ -0,0 +1,228 @@
+/*
+ * LatticeMatch calculator - plain text output
+ * Copyright (C) 2015 Andreas Grois
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ *
+ * Writes the results in the good old "lower upper" format, one range per line, in degrees.
+ * The output is byte for byte what the cout-based code used to print, just without iostreams.
+ *
+ * This class is part of the LatticeMatch program.
+ *
+ * To contact the author either use electronic mail: Andreas Grois <andreas.grois@jku.at>
+ * or write to:
+ * Andreas Grois, Institute for Semiconductor and SolidState physics, Johannes Kepler University,
+ * Altenbergerstraße 69, 4040 Linz, AUSTRIA
+ */
+
+#include "textwriter.h"
+#include <cmath>
+
+textwriter::textwriter(outbuffer &target, bool fullprecision) : out(target)
+{
+    this->fullprecision=fullprecision;
+}
+
+void textwriter::writenumber(double value)
+{
+    if(fullprecision)
+    {
+        out.appendshortest(value);
+    }
+    else
+    {
+        out.appendg(value);
+    }
+}
+
+void textwriter::writeset(angleset &ranges, const provenance *labels, bool commensurate, const std::vector<unsigned int> *orders,
+                          const std::vector<bestangle::fit> *fits)
+{
+    //by reference, no need to copy every range.
+    const std::vector<anglerange> &storage=ranges.getrangesref();
+    for(std::vector<anglerange>::const_iterator i=storage.begin();i!=storage.end();++i)
+    {
+        //written exactly like the old cout code did, so the rounding doesn't change.
+        writenumber(i->getlower().getval()*180/M_PI);
+        out.append(' ');
+        writenumber(i->getupper().getval()*180/M_PI);
+        if(labels)
+        {
+            size_t k=i-storage.begin();
+            const epitaxymatrix *matrices=labels->labels(commensurate,k);
+            for(size_t j=0;j<labels->count(commensurate,k);j++)
+            {
+                writematrix(matrices[j]);
+            }
+        }
+        if(orders && static_cast<size_t>(i-storage.begin())<orders->size())
+        {
+            out.append(" order ");
+            out.appendu((*orders)[i-storage.begin()]);
+        }
+        if(fits && static_cast<size_t>(i-storage.begin())<fits->size())
+        {
+            const bestangle::fit &best=(*fits)[i-storage.begin()];
+            out.append(" best ");
+            writenumber(best.theta*180/M_PI);
+            out.append(" misfit ");
+            writenumber(best.misfit);
+        }
+        out.append('\n');
+    }
+}
+
+void textwriter::writematrix(const epitaxymatrix &matrix)
+{
+    const int entries[4]={matrix.px,matrix.qx,matrix.qy,matrix.py};
+    out.append(matrix.loop==1 ? " h(" : " (");
+    for(int i=0;i<4;i++)
+    {
+        if(i>0)
+        {
+            out.append(' ');
+        }
+        if(entries[i]==provenance::FREE)
+        {
+            out.append('*');
+            continue;
+        }
+        if(entries[i]<0)
+        {
+            out.append('-');
+        }
+        out.appendu(entries[i]<0 ? -static_cast<long long>(entries[i]) : entries[i]);
+    }
+    out.append(')');
+}
+
+void textwriter::writesteps(const std::vector<coverage::step> &steps)
+{
+    for(std::vector<coverage::step>::const_iterator i=steps.begin();i!=steps.end();++i)
+    {
+        writenumber(i->lower*180/M_PI);
+        out.append(' ');
+        writenumber(i->upper*180/M_PI);
+        out.append(' ');
+        out.appendu(i->count);
+        out.append('\n');
+    }
+}
+
+void textwriter::writeextension(double b1max, double b2max)
+{
+    out.append("Extended to b1max=");
+    writenumber(b1max);
+    out.append(", b2max=");
+    writenumber(b2max);
+    out.append(":\n");
+}
+
+void textwriter::writesweeppoint(unsigned int index, double b1min, double b1max)
+{
+    out.append("Sweep point ");
+    out.appendu(index);
+    out.append(": b1min=");
+    writenumber(b1min);
+    out.append(", b1max=");
+    writenumber(b1max);
+    out.append(":\n");
+}
+
+void textwriter::writeshell(unsigned int maxindex, bool complete)
+{
+    out.append("Indices up to ");
+    out.appendu(maxindex);
+    out.append(complete ? ", complete:\n" : ":\n");
+}
+
+void textwriter::writebatchentry(unsigned int index)
+{
+    out.append("Batch entry ");
+    out.appendu(index);
+    out.append(":\n");
+}
+
+void textwriter::writeresults(matchsolver &solver)
+{
+    const provenance &labels=solver.getprovenance();
+    const bool ordered=!solver.getorders(false).empty() || !solver.getorders(true).empty();
+    const bool fitted=!solver.getfits(false).empty() || !solver.getfits(true).empty();
+    if(!labels.isvalid() && !ordered && !fitted)
+    {
+        writesets(solver.getcoincident(),solver.getcommensurate());
+    }
+    else
+    {
+        const provenance *given = labels.isvalid() ? &labels : 0;
+        out.append("Coincident Matches:\n");
+        writeset(solver.getcoincident(),given,false,ordered ? &solver.getorders(false) : 0,fitted ? &solver.getfits(false) : 0);
+        out.append("Commensurate Matches:\n");
+        writeset(solver.getcommensurate(),given,true,ordered ? &solver.getorders(true) : 0,fitted ? &solver.getfits(true) : 0);
+    }
+    const coverage &multiplicity=solver.getcoverage();
+    if(multiplicity.isvalid())
+    {
+        out.append("Coincident Multiplicity:\n");
+        writesteps(multiplicity.getsteps(false));
+        out.append("Commensurate Multiplicity:\n");
+        writesteps(multiplicity.getsteps(true));
+    }
+    out.flushmaybe();
+}
+
+void textwriter::writeexists(matchsolver &, bool exists)
+{
+    out.append(exists ? "Commensurate Matches: yes\n" : "Commensurate Matches: no\n");
+    out.flushmaybe();
+}
+
+void textwriter::writecount(matchsolver &, unsigned long count)
+{
+    out.append("Commensurate Matches: ");
+    out.appendu(count);
+    out.append('\n');
+    out.flushmaybe();
+}
+
+void textwriter::writesets(angleset &coincident, angleset &commensurate)
+{
+    out.append("Coincident Matches:\n");
+    writeset(coincident);
+    out.append("Commensurate Matches:\n");
+    writeset(commensurate);
+    out.flushmaybe();
+}
+
+void textwriter::writefinalrange(bool commensurate, const anglerange &range)
+{
+    out.append(commensurate ? "Commensurate Match: " : "Coincident Match: ");
+    writenumber(range.getlower().getval()*180/M_PI);
+    out.append(' ');
+    writenumber(range.getupper().getval()*180/M_PI);
+    out.append('\n');
+}
+
+void textwriter::writesectordone()
+{
+    //whoever is watching wants to see the ranges now.
+    out.flush();
+}
+
+void textwriter::flush()
+{
+    out.flush();
+}
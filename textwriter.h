@@ -0,0 +1,72 @@
+/*
+ * LatticeMatch calculator - plain text output
+ * Copyright (C) 2015 Andreas Grois
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ *
+ * Writes the results in the good old "lower upper" format, one range per line, in degrees.
+ * The output is byte for byte what the cout-based code used to print, just without iostreams.
+ *
+ * This class is part of the LatticeMatch program.
+ *
+ * To contact the author either use electronic mail: Andreas Grois <andreas.grois@jku.at>
+ * or write to:
+ * Andreas Grois, Institute for Semiconductor and SolidState physics, Johannes Kepler University,
+ * Altenbergerstraße 69, 4040 Linz, AUSTRIA
+ */
+
+#ifndef TEXTWRITER_H
+#define TEXTWRITER_H
+
+#include "resultwriter.h"
+#include "outbuffer.h"
+
+class textwriter : public resultwriter, public matchsink
+{
+private:
+    outbuffer &out;
+    bool fullprecision;
+    void writenumber(double value);
+    //labels, if given, are written after each range: " (px qx qy py)" per matrix, * for a free entry, and an h in
+    //front for the second run of a hexagonal substrate.
+    //orders, if given, are written the same way, " order d" with the smallest denominator of the range, and
+    //fits as " best theta misfit m".
+    void writeset(angleset &ranges, const provenance *labels=0, bool commensurate=false, const std::vector<unsigned int> *orders=0,
+                  const std::vector<bestangle::fit> *fits=0);
+    void writematrix(const epitaxymatrix &matrix);
+    //"lower upper count" per step, see coverage.h.
+    void writesteps(const std::vector<coverage::step> &steps);
+public:
+    //fullprecision prints the shortest round-trip representation instead of cout's 6 digits.
+    textwriter(outbuffer &target, bool fullprecision=false);
+
+    void writeextension(double b1max, double b2max);
+    void writesweeppoint(unsigned int index, double b1min, double b1max);
+    void writeshell(unsigned int maxindex, bool complete);
+    void writebatchentry(unsigned int index);
+    void writeresults(matchsolver &solver);
+    void writeexists(matchsolver &solver, bool exists);
+    void writecount(matchsolver &solver, unsigned long count);
+    //the same, for sets that didn't come from a solver
+    void writesets(angleset &coincident, angleset &commensurate);
+    void flush();
+
+    //streaming: one line per range, "Coincident Match: lower upper" or "Commensurate Match: lower upper"
+    void writefinalrange(bool commensurate, const anglerange &range);
+    void writesectordone();
+};
+
+#endif // TEXTWRITER_H
@@ -0,0 +1,159 @@
+/*
+ * LatticeMatch calculator - brute force scan over theta
+ * Copyright (C) 2015 Andreas Grois
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ *
+ * See thetascan.h.
+ *
+ * This class is part of the LatticeMatch program.
+ *
+ * To contact the author either use electronic mail: Andreas Grois <andreas.grois@jku.at>
+ * or write to:
+ * Andreas Grois, Institute for Semiconductor and SolidState physics, Johannes Kepler University,
+ * Altenbergerstraße 69, 4040 Linz, AUSTRIA
+ */
+
+#include "thetascan.h"
+#include "matchsolver.h"
+#include <cmath>
+
+//two grid points, and what comparing them gives. Vector extensions of GCC and clang, like the atomics in shmwriter.
+//Two doubles are what every x86-64 (SSE2) and arm64 (NEON) machine has, wider vectors would need extra flags.
+typedef double vec __attribute__((vector_size(16)));
+typedef long long mask __attribute__((vector_size(16)));
+static const unsigned int lanes=2;
+
+//grid points per block: the fine table covers the points of one block, the start of each block is evaluated directly.
+static const unsigned int blocksize=64;
+//an entry that reaches an integer exactly on a border of the windows shouldn't get lost to rounding.
+static const double slack=1e-12;
+
+//one entry of the matrix: b*sin(c+d)*scale, with b in [bmin:bmax] and d in [-h:h].
+struct entry
+{
+    double coshalf, sinhalf; //cos(h) and sin(h). h is half the beta window for the second column, 0 for the first.
+    double bmin, bmax;
+    double scale;
+};
+
+static inline vec splat(double x)
+{
+    vec v={x,x};
+    return(v);
+}
+
+static inline vec choose(mask m, vec yes, vec no)
+{
+    return((vec)(((mask)yes & m) | ((mask)no & ~m)));
+}
+
+//the lanes where the entry can be an integer, given sin(c) and cos(c).
+static inline mask integerband(vec sinc, vec cosc, const entry &e)
+{
+    //the sine on [c-h:c+h] is between its values at the ends, unless its maximum or minimum is inside.
+    vec middle=sinc*splat(e.coshalf), spread=cosc*splat(e.sinhalf);
+    spread=choose(spread<splat(0.0),-spread,spread);
+    vec upper=choose(sinc>=splat(e.coshalf),splat(1.0),middle+spread);
+    vec lower=choose(-sinc>=splat(e.coshalf),splat(-1.0),middle-spread);
+    //b is positive: the longest one goes furthest out on either side of 0.
+    upper=choose(upper>=splat(0.0),upper*splat(e.bmax),upper*splat(e.bmin));
+    lower=choose(lower>=splat(0.0),lower*splat(e.bmin),lower*splat(e.bmax));
+    vec centre=(upper+lower)*splat(0.5*e.scale);
+    vec half=(upper-lower)*splat(0.5*fabs(e.scale))+splat(slack);
+    //rounds to the nearest integer, as long as |centre|<2^51.
+    const vec magic=splat(6755399441055744.0);
+    vec distance=centre-((centre+magic)-magic);
+    return(distance*distance<=half*half);
+}
+
+thetascan::thetascan(const double input[9], int loops)
+{
+    for(int i=0;i<9;i++)
+    {
+        params[i]=input[i];
+    }
+    this->loops=loops;
+}
+
+void thetascan::scan(unsigned int points, std::vector<unsigned char> &flags) const
+{
+    flags.assign(points,0);
+    if(points==0)
+    {
+        return;
+    }
+    //theta of grid point k=block*blocksize+r is the sum of those of block*blocksize and r.
+    vec finesin[blocksize/lanes], finecos[blocksize/lanes];
+    for(unsigned int r=0;r<blocksize;r++)
+    {
+        finesin[r/lanes][r%lanes]=sin(2*M_PI*r/points);
+        finecos[r/lanes][r%lanes]=cos(2*M_PI*r/points);
+    }
+    const double halfbeta=(params[matchsolver::BETAMAX]-params[matchsolver::BETAMIN])/2;
+    const double centrebeta=(params[matchsolver::BETAMAX]+params[matchsolver::BETAMIN])/2;
+    //per loop: px, qx, qy, py, and the angles the sines are turned by: alpha for px, alpha-beta for qx, beta for py.
+    entry entries[2][4];
+    double turns[2][3][2];
+    for(int l=0;l<loops;l++)
+    {
+        const double alpha=params[matchsolver::ALPHA]+l*M_PI/3.0;
+        const double first=1.0/(params[matchsolver::A1]*sin(alpha)), second=1.0/(params[matchsolver::A2]*sin(alpha));
+        const entry px={1.0,0.0,params[matchsolver::B1MIN],params[matchsolver::B1MAX],first};
+        const entry qx={cos(halfbeta),sin(halfbeta),params[matchsolver::B2MIN],params[matchsolver::B2MAX],first};
+        const entry qy={1.0,0.0,params[matchsolver::B1MIN],params[matchsolver::B1MAX],second};
+        const entry py={cos(halfbeta),sin(halfbeta),params[matchsolver::B2MIN],params[matchsolver::B2MAX],second};
+        entries[l][0]=px;
+        entries[l][1]=qx;
+        entries[l][2]=qy;
+        entries[l][3]=py;
+        const double angles[3]={alpha,alpha-centrebeta,centrebeta};
+        for(int t=0;t<3;t++)
+        {
+            turns[l][t][0]=sin(angles[t]);
+            turns[l][t][1]=cos(angles[t]);
+        }
+    }
+    const mask none={0,0};
+    for(unsigned int block=0;block*blocksize<points;block++)
+    {
+        const double start=2*M_PI*(static_cast<double>(block)*blocksize)/points;
+        const vec startsin=splat(sin(start)), startcos=splat(cos(start));
+        for(unsigned int g=0;g<blocksize/lanes;g++)
+        {
+            const vec sint=startsin*finecos[g]+startcos*finesin[g];
+            const vec cost=startcos*finecos[g]-startsin*finesin[g];
+            mask coincident=none, commensurate=none;
+            for(int l=0;l<loops;l++)
+            {
+                const double (*turn)[2]=turns[l];
+                //alpha-theta, alpha-beta-theta and theta+beta.
+                const vec sinp=splat(turn[0][0])*cost-splat(turn[0][1])*sint, cosp=splat(turn[0][1])*cost+splat(turn[0][0])*sint;
+                const vec sinq=splat(turn[1][0])*cost-splat(turn[1][1])*sint, cosq=splat(turn[1][1])*cost+splat(turn[1][0])*sint;
+                const vec sinr=sint*splat(turn[2][1])+cost*splat(turn[2][0]), cosr=cost*splat(turn[2][1])-sint*splat(turn[2][0]);
+                mask x=integerband(sinp,cosp,entries[l][0]) & integerband(sinq,cosq,entries[l][1]);
+                mask y=integerband(sint,cost,entries[l][2]) & integerband(sinr,cosr,entries[l][3]);
+                coincident|=x|y;
+                commensurate|=x&y;
+            }
+            const unsigned int base=block*blocksize+lanes*g;
+            for(unsigned int lane=0;lane<lanes && base+lane<points;lane++)
+            {
+                flags[base+lane]=(coincident[lane] ? SCAN_COINCIDENT : 0) | (commensurate[lane] ? SCAN_COMMENSURATE : 0);
+            }
+        }
+    }
+}
@@ -0,0 +1,66 @@
+/*
+ * LatticeMatch calculator - brute force scan over theta
+ * Copyright (C) 2015 Andreas Grois
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ *
+ * The most naive way to find the matches, kept as a baseline to check the range solver against: go around the
+ * circle in small steps, and look at each theta on its own. For a fixed theta every entry of the epitaxy matrix
+ * is a function of the adlayer vector lengths and of beta only,
+ *   px = b1 sin(alpha-theta) / (a1 sin(alpha))
+ *   qx = b2 sin(alpha-theta-beta) / (a1 sin(alpha))
+ *   qy = b1 sin(theta) / (a2 sin(alpha))
+ *   py = b2 sin(theta+beta) / (a2 sin(alpha))
+ * and takes all values in an interval while b1, b2 and beta run through their windows. The entry can be an integer
+ * if that interval holds one. theta is coincident if both entries of one column can, and commensurate if all four
+ * can, just like the range solver decides it, where each column has its own b and beta.
+ *
+ * Two grid points are done at once, with the vector extensions of GCC and clang. No sine is evaluated in the
+ * loop: sin(theta) and cos(theta) come from two small tables by the addition theorem, everything else is a
+ * rotation of those by a constant angle, and the rounding to the nearest integer is done by adding and
+ * subtracting 1.5*2^52. The cost is proportional to the number of grid points, no matter how large the indices.
+ *
+ * The result is only as fine as the grid: ranges narrower than a step can fall through it, points always do.
+ *
+ * This class is part of the LatticeMatch program.
+ *
+ * To contact the author either use electronic mail: Andreas Grois <andreas.grois@jku.at>
+ * or write to:
+ * Andreas Grois, Institute for Semiconductor and SolidState physics, Johannes Kepler University,
+ * Altenbergerstraße 69, 4040 Linz, AUSTRIA
+ */
+
+#ifndef THETASCAN_H
+#define THETASCAN_H
+
+#include <vector>
+
+class thetascan
+{
+public:
+    //or-ed together in the flags of each grid point.
+    enum scanflags{SCAN_COINCIDENT=1,SCAN_COMMENSURATE=2};
+private:
+    double params[9];
+    int loops;
+public:
+    //sanitized parameters, as for matchsolver, and the number of runs (2 for hexagonal substrates, alpha+60 degrees).
+    thetascan(const double input[9], int loops);
+    //flags gets one entry per grid point, theta=2 pi k/points for k in [0:points).
+    void scan(unsigned int points, std::vector<unsigned char> &flags) const;
+};
+
+#endif // THETASCAN_H